@@ -0,0 +1,28 @@
+// allocations.cpp
+#include <bits/stdc++.h>
+using namespace std;
+
+// ————————————————————————————— Allocation Counting —————————————————————————————
+// Replaces the program's global operator new and delete with ones that feed
+// the allocation counters of pipeline.cpp while countAllocations is set.
+// Included once, after pipeline.cpp, by the analyzer and the benchmark; the
+// library leaves the host's operator new alone.
+//
+// GCC cannot see that the free() below pairs with the malloc() in operator
+// new, hence the pragma.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void* operator new(size_t n) {
+    if (countAllocations.load(memory_order_relaxed)) {
+        allocationCount.fetch_add(1, memory_order_relaxed);
+        allocatedBytes.fetch_add(n, memory_order_relaxed);
+    }
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#pragma GCC diagnostic pop
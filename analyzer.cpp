@@ -1,47 +1,482 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
-#include "semantic.cpp"  // Includes syntax.cpp → lexical.cpp
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "pipeline.cpp"  // Includes cache.cpp → output.cpp → semantic.cpp → syntax.cpp → lexical.cpp
+#include "allocations.cpp"  // counts every operator new once profiling is on
 
 using namespace std;
 
-int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        cerr << "Usage: analyzer <mode> <input_file>\n";
+// ————————————————————————————— Input Loading —————————————————————————————
+// Regular files are memory-mapped so the lexer scans the page cache directly;
+// pipes, terminals and "-" (stdin) fall back to a buffered read into memory.
+class SourceFile {
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    string buffer;
+
+public:
+    SourceFile() = default;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    ~SourceFile() {
+        if (mapped)
+            munmap((void*)data, size);
+    }
+
+    bool open(const string& filename) {
+        int fd = filename == "-" ? STDIN_FILENO : ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                data = (const char*)p;
+                size = st.st_size;
+                mapped = true;
+            }
+        }
+        if (ok && !mapped)
+            ok = readAll(fd);
+
+        if (fd != STDIN_FILENO)
+            close(fd);
+        return ok;
+    }
+
+    string_view text() const { return string_view(data, size); }
+    const char* method() const { return mapped ? "mmap" : "read"; }
+
+private:
+    bool readAll(int fd) {
+        char chunk[1 << 16];
+        while (true) {
+            ssize_t r = read(fd, chunk, sizeof(chunk));
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) return false;
+            if (r == 0) break;
+            buffer.append(chunk, r);
+        }
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+    }
+};
+
+// ————————————————————————————— Server Mode —————————————————————————————
+// `analyzer --serve [socket_path]` keeps one process warm and answers many
+// requests, either over stdin/stdout or over a Unix domain socket.
+//
+// Request:   "<mode> [<format>] <length>\n" followed by exactly <length> bytes
+//            of source, which becomes the connection's current document, or
+//            "edit <mode> [<format>] <offset> <removed> <length>\n" followed by <length>
+//            bytes that replace <removed> bytes at <offset> of the current
+//            document; only the tokens around the edit are re-lexed, and
+//            only the top-level items around those are parsed again.
+//            The run's error limit is the one given with --max-errors, the
+//            output format (text, json, binary) the --format one unless the
+//            request names another.
+//            "stats 0\n" asks for the --cache counters.
+// Response:  "ok <length>\n" + phase output, or "error <length>\n" + diagnostics.
+//
+// A connection may carry any number of requests; EOF ends it. Each socket
+// connection is served on a thread of its own, with its own document, so an
+// idle client holds up no one else; the --cache directory is shared. With --cache,
+// a document whose text was analyzed before is answered from its snapshot
+// and is only lexed again when a later request misses.
+//
+// A document may be at most maxRequestBytes long, and at most maxConnections
+// socket connections are served at once. A request over the size limit, or a
+// connection past the connection limit, gets an error reply and is closed.
+const size_t maxRequestBytes = 256 << 20;
+const unsigned maxConnections = 64;
+
+static bool readExact(int fd, char* buf, size_t n) {
+    while (n > 0) {
+        ssize_t r = read(fd, buf, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        buf += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const char* buf, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, buf, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        buf += w;
+        n -= w;
+    }
+    return true;
+}
+
+static bool readHeader(int fd, string& line) {
+    line.clear();
+    char c;
+    while (readExact(fd, &c, 1)) {
+        if (c == '\n') return true;
+        line += c;
+        if (line.size() > 256) return false;  // not a header, drop the connection
+    }
+    return false;
+}
+
+static void replyError(int out, const string& msg) {
+    string reply = "error " + to_string(msg.size()) + "\n" + msg;
+    writeAll(out, reply.data(), reply.size());
+}
+
+// Serves requests from `in` until EOF, a malformed header or an oversized
+// document; replies on `out`.
+static void serveConnection(int in, int out, const runOptions& opts) {
+    string header, text;
+    unique_ptr<document> doc;
+    while (readHeader(in, header)) {
+        string mode, format;
+        size_t offset = 0, removed = 0, length = 0;
+        runOptions request = opts;
+        istringstream hs(header);
+        bool edit = header.rfind("edit ", 0) == 0;
+        if (edit) hs >> mode;  // skip the "edit" keyword
+        bool ok = bool(hs >> mode);
+        if (ok && isalpha((hs >> ws).peek()))  // optional format
+            ok = (hs >> format) && parseFormat(format, request.format);
+        if (!ok || (edit && !(hs >> offset >> removed)) || !(hs >> length)) {
+            replyError(out, "Malformed request header.\n");
+            return;
+        }
+        size_t kept = edit && doc ? doc->code->size() - min(removed, doc->code->size()) : 0;
+        if (length > maxRequestBytes - kept) {
+            replyError(out, "Document larger than " + to_string(maxRequestBytes >> 20) + " MB.\n");
+            return;  // the payload is not read, so the connection cannot go on
+        }
+
+        text.resize(length);
+        if (!readExact(in, &text[0], length)) return;
+
+        ostringstream result, diagnostics;
+        int status = 1;
+        if (mode == "stats" && !edit) {
+            result << (opts.cache ? opts.cache->stats() : "cache off\n");
+            status = 0;
+        } else if (!validMode(mode)) {
+            reportFailure("Invalid mode.", request, diagnostics);
+        } else if (!edit) {
+            doc = make_unique<document>();
+            auto next = make_unique<string>();
+            next->swap(text);
+            status = analyzeDocument(*doc, move(next), nullptr, mode, result, diagnostics, request);
+        } else if (!doc || offset > doc->code->size() || removed > doc->code->size() - offset) {
+            reportFailure("Edit outside the current document.", request, diagnostics);
+        } else {
+            textEdit e{ offset, removed, text };
+            auto next = make_unique<string>(applyEdit(*doc->code, e));
+            status = analyzeDocument(*doc, move(next), &e, mode, result, diagnostics, request);
+        }
+        string payload = status == 0 ? result.str() : diagnostics.str();
+        string reply = (status == 0 ? "ok " : "error ") + to_string(payload.size()) + "\n";
+        if (!writeAll(out, reply.data(), reply.size()) ||
+            !writeAll(out, payload.data(), payload.size()))
+            return;
+    }
+}
+
+static int serveSocket(const string& path, const runOptions& opts) {
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        cerr << "Could not create socket.\n";
         return 1;
     }
 
-    string mode = argv[1];
-    string filename = argv[2];
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Socket path too long.\n";
+        return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
 
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Could not open input file.\n";
+    if (bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 16) < 0) {
+        cerr << "Could not listen on " << path << ".\n";
         return 1;
     }
 
-    string code((istreambuf_iterator<char>(file)), {});
-    vector<token> toks = tokenize(code);
-
-    if (mode == "lexical") {
-        for (const auto& t : toks) {
-            cout << "Type: " << tokenToString(t.type)
-                 << ", Value: '" << t.value
-                 << "', Line: " << t.line
-                 << ", Column: " << t.col << "\n";
-        }
-    } else if (mode == "syntax") {
-        Parser p(toks);
-        p.parse();
-    } else if (mode == "semantic") {
-        //Parser p(toks);
-        //p.parse();
-        SemanticAnalyzer sem(toks);
-        sem.analyze();
-    } else {
-        cerr << "Invalid mode.\n";
+    static atomic<unsigned> connections{ 0 };  // being served; only this thread adds to it
+    while (true) {
+        int conn = accept(listener, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (connections >= maxConnections) {
+            replyError(conn, "Server busy: " + to_string(maxConnections) + " connections open.\n");
+            close(conn);
+            continue;
+        }
+        connections++;
+        thread([conn, &opts] {
+            serveConnection(conn, conn, opts);
+            close(conn);
+            connections--;
+        }).detach();
+    }
+    close(listener);
+    return 1;
+}
+
+// ————————————————————————————— Batch Mode —————————————————————————————
+// `analyzer --batch <mode> <file|directory>...` analyzes many files in one
+// process. Directories contribute their C++ sources (.cpp, .cc, .cxx), sorted
+// by path. Files are spread over the workers' queues round-robin; a worker
+// takes its own tasks in order from the front of its queue and, once that is
+// empty, steals from the back of another's, so a few large files do not keep
+// one worker busy while the rest sit idle. Results are printed in input
+// order as soon as each one and all before it are ready.
+
+class WorkStealingPool {
+    struct taskQueue {
+        mutex lock;
+        deque<size_t> tasks;
+    };
+    vector<taskQueue> queues;
+
+public:
+    explicit WorkStealingPool(unsigned workers) : queues(max(1u, workers)) {}
+
+    // Runs fn(0) … fn(taskCount - 1) on the workers; returns when all are done.
+    template <class F>
+    void run(size_t taskCount, F fn) {
+        for (size_t t = 0; t < taskCount; t++)
+            queues[t % queues.size()].tasks.push_back(t);
+        vector<thread> workers;
+        for (size_t w = 0; w < queues.size(); w++) {
+            workers.emplace_back([this, w, &fn] {
+                size_t task;
+                while (take(w, task))
+                    fn(task);
+            });
+        }
+        for (thread& w : workers)
+            w.join();
+    }
+
+private:
+    bool take(size_t self, size_t& task) {
+        for (size_t k = 0; k < queues.size(); k++) {
+            taskQueue& q = queues[(self + k) % queues.size()];
+            lock_guard<mutex> guard(q.lock);
+            if (q.tasks.empty())
+                continue;
+            if (k == 0) {
+                task = q.tasks.front();
+                q.tasks.pop_front();
+            } else {
+                task = q.tasks.back();
+                q.tasks.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+static bool isSourceFile(const filesystem::path& p) {
+    string ext = p.extension().string();
+    return ext == ".cpp" || ext == ".cc" || ext == ".cxx";
+}
+
+// Expands directories; returns false (after saying why) if a path is unusable.
+static bool collectInputs(int count, char* paths[], vector<string>& files) {
+    for (int k = 0; k < count; k++) {
+        error_code ec;
+        filesystem::path p(paths[k]);
+        if (filesystem::is_directory(p, ec)) {
+            vector<string> found;
+            for (auto& entry : filesystem::recursive_directory_iterator(p, ec))
+                if (entry.is_regular_file(ec) && isSourceFile(entry.path()))
+                    found.push_back(entry.path().string());
+            sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else if (filesystem::exists(p, ec)) {
+            files.push_back(p.string());
+        } else {
+            cerr << "No such file or directory: " << paths[k] << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+static int runBatch(const string& mode, const vector<string>& files, unsigned workers, runOptions opts) {
+    struct fileResult {
+        string text;
+        int status = 0;
+        bool done = false;
+    };
+    vector<fileResult> results(files.size());
+    mutex lock;
+    condition_variable ready;
+    opts.threads = 1;  // the files are the unit of parallelism
+
+    auto start = chrono::steady_clock::now();
+    thread printer([&] {
+        for (size_t k = 0; k < files.size(); k++) {
+            unique_lock<mutex> guard(lock);
+            ready.wait(guard, [&] { return results[k].done; });
+            string text = move(results[k].text);
+            guard.unlock();
+            cout << "==== " << files[k] << (results[k].status ? ": error" : "") << " ====\n" << text;
+        }
+        cout.flush();
+    });
+
+    WorkStealingPool pool(workers);
+    pool.run(files.size(), [&](size_t k) {
+        ostringstream out, err;
+        SourceFile source;
+        int status = 1;
+        if (source.open(files[k]))
+            status = runMode(mode, source.text(), out, err, opts);
+        else
+            reportFailure("Could not open input file.", opts, err);
+        lock_guard<mutex> guard(lock);
+        results[k].text = status == 0 ? out.str() : err.str();
+        results[k].status = status;
+        results[k].done = true;
+        ready.notify_all();
+    });
+    printer.join();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t failed = count_if(results.begin(), results.end(), [](const fileResult& r) { return r.status != 0; });
+    cerr << "Batch: " << files.size() << " files (" << failed << " with errors) in "
+         << fixed << setprecision(3) << secs << " s, " << setprecision(1)
+         << files.size() / max(secs, 1e-9) << " files/s on " << max(1u, workers) << " threads\n";
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Optional flags come before the positional arguments.
+    bool timing = false, profiling = false, serve = false, batch = false, threadsGiven = false;
+    string cacheDir;
+    size_t cacheMb = 256;
+    runOptions opts;
+    int arg = 1;
+    for (; arg < argc && string(argv[arg]).rfind("--", 0) == 0; arg++) {
+        string flag = argv[arg];
+        if (flag == "--timing") {
+            timing = true;
+        } else if (flag == "--profile") {
+            profiling = true;
+        } else if (flag == "--serve") {
+            serve = true;
+        } else if (flag == "--batch") {
+            batch = true;
+        } else if (flag == "--max-errors" && arg + 1 < argc) {
+            opts.maxErrors = strtoul(argv[++arg], nullptr, 10);
+        } else if (flag == "--format" && arg + 1 < argc) {
+            if (!parseFormat(argv[++arg], opts.format)) {
+                cerr << "Unknown format " << argv[arg] << " (text, json or binary)\n";
+                return 1;
+            }
+        } else if (flag == "--cache" && arg + 1 < argc) {
+            cacheDir = argv[++arg];
+        } else if (flag == "--cache-size" && arg + 1 < argc) {
+            cacheMb = strtoul(argv[++arg], nullptr, 10);
+        } else if (flag == "--threads" && arg + 1 < argc) {
+            opts.threads = max(1ul, strtoul(argv[++arg], nullptr, 10));
+            threadsGiven = true;
+        } else {
+            cerr << "Unknown option " << argv[arg] << "\n";
+            return 1;
+        }
+    }
+
+    optional<ResultCache> cache;
+    if (!cacheDir.empty()) {
+        cache.emplace(cacheDir, cacheMb << 20);
+        opts.cache = &*cache;
+    }
+
+    if (serve) {
+        signal(SIGPIPE, SIG_IGN);  // a client hanging up must not kill the server
+        if (arg < argc)
+            return serveSocket(argv[arg], opts);
+        serveConnection(STDIN_FILENO, STDOUT_FILENO, opts);
+        return 0;
+    }
+
+    if (argc - arg < 2) {
+        cerr << "Usage: analyzer [--timing] [--profile] [options] <mode> <input_file|->\n"
+             << "       analyzer [options] --serve [socket_path]\n"
+             << "       analyzer [options] --batch <mode> <file|directory>...\n"
+             << "Options: --max-errors N, --threads N, --format text|json|binary,\n"
+             << "         --cache DIR, --cache-size MB\n"
+             << "       (--max-errors 0 reports every error; default "
+             << Diagnostics::defaultLimit << ")\n"
+             << "       (--threads N splits the lexing of large inputs over N threads,\n"
+             << "        except in lexical mode, which streams its tokens;\n"
+             << "        with --batch it is the number of files analyzed at once)\n"
+             << "       (--profile writes phase times and counters to stderr as one JSON line)\n"
+             << "       (--cache keeps finished runs in DIR and answers repeated sources from\n"
+             << "        there, in any mode; --cache-size caps DIR, default 256 MB)\n";
         return 1;
     }
 
-    return 0;
+    if (batch) {
+        vector<string> files;
+        if (!validMode(argv[arg]))
+            return reportFailure("Invalid mode.", opts, cerr);
+        if (!collectInputs(argc - arg - 1, argv + arg + 1, files))
+            return 1;
+        unsigned workers = threadsGiven ? opts.threads : thread::hardware_concurrency();
+        return runBatch(argv[arg], files, workers, opts);
+    }
+
+    string mode = argv[arg];
+    string filename = argv[arg + 1];
+
+    runProfile profile;
+    if (profiling) {
+        opts.profile = &profile;
+        countAllocations = true;
+    }
+
+    auto loadStart = chrono::steady_clock::now();
+    SourceFile source;
+    bool loaded = false;
+    timed(opts, "load", [&] { loaded = source.open(filename); });
+    if (!loaded)
+        return reportFailure("Could not open input file.", opts, cerr);
+    double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+
+    // Reported on stderr so the phase output itself stays unchanged.
+    if (timing) {
+        cerr << "Load: " << source.text().size() << " bytes via " << source.method()
+             << " in " << fixed << setprecision(3) << loadMs << " ms\n";
+    }
+
+    int status = runMode(mode, source.text(), cout, cerr, opts);
+    if (profiling) {
+        cout.flush();
+        profile.print(cerr);
+    }
+    return status;
 }
@@ -0,0 +1,127 @@
+// analyzer_api.cpp
+#include <bits/stdc++.h>
+#include "analyzer_api.h"
+#include "pipeline.cpp"  // Includes cache.cpp → output.cpp → semantic.cpp → syntax.cpp → lexical.cpp
+using namespace std;
+
+// ————————————————————————————— C API —————————————————————————————
+// The runs go through runMode() and analyzeDocument(), as in ./analyzer and
+// its server mode. No exception crosses into the caller: a run that throws
+// anything but the error limit returns NULL.
+
+struct pva_document {
+    document doc;
+};
+
+static optional<ResultCache> apiCache;
+
+// The result struct and its bytes in one block, freed with free().
+static pva_result* makeResult(int status, const string& text) {
+    void* block = malloc(sizeof(pva_result) + text.size() + 1);
+    if (!block)
+        return nullptr;
+    pva_result* r = (pva_result*)block;
+    char* data = (char*)(r + 1);
+    memcpy(data, text.data(), text.size());
+    data[text.size()] = '\0';
+    r->status = status;
+    r->length = text.size();
+    r->data = data;
+    return r;
+}
+
+// Reads the arguments every call shares; false (after a failure result in
+// `r`) if they are unusable.
+static bool readRequest(const char* mode, const char* source, size_t length, const char* format,
+                        size_t maxErrors, runOptions& opts, pva_result*& r) {
+    opts.maxErrors = maxErrors;
+    opts.cache = apiCache ? &*apiCache : nullptr;
+    if (format && !parseFormat(format, opts.format)) {
+        ostringstream err;
+        reportFailure("Unknown format.", opts, err);
+        r = makeResult(1, err.str());
+        return false;
+    }
+    if (!mode || (!source && length)) {
+        ostringstream err;
+        reportFailure("Missing mode or source.", opts, err);
+        r = makeResult(1, err.str());
+        return false;
+    }
+    return true;
+}
+
+extern "C" {
+
+pva_result* pva_analyze(const char* mode, const char* source, size_t length,
+                        const char* format, size_t max_errors) {
+    try {
+        runOptions opts;
+        pva_result* r = nullptr;
+        if (!readRequest(mode, source, length, format, max_errors, opts, r))
+            return r;
+        ostringstream out, err;
+        int status = runMode(mode, string_view(source, length), out, err, opts);
+        return makeResult(status, status == 0 ? out.str() : err.str());
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+pva_document* pva_document_new(void) {
+    try {
+        return new pva_document();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+pva_result* pva_document_analyze(pva_document* doc, const char* mode, const char* source,
+                                 size_t length, const char* format, size_t max_errors) {
+    try {
+        runOptions opts;
+        pva_result* r = nullptr;
+        if (!readRequest(mode, source, length, format, max_errors, opts, r))
+            return r;
+        ostringstream out, err;
+        int status = 1;
+        if (!doc) {
+            reportFailure("No document.", opts, err);
+        } else if (!validMode(mode)) {
+            reportFailure("Invalid mode.", opts, err);
+        } else {
+            string_view text(source, length);
+            textEdit e = diffEdit(*doc->doc.code, text);
+            status = analyzeDocument(doc->doc, make_unique<string>(text), &e, mode, out, err, opts);
+        }
+        return makeResult(status, status == 0 ? out.str() : err.str());
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void pva_document_free(pva_document* doc) {
+    delete doc;
+}
+
+void pva_free_result(pva_result* result) {
+    free(result);
+}
+
+int pva_enable_cache(const char* dir, size_t megabytes) {
+    try {
+        if (!dir || !*dir)
+            return -1;
+        apiCache.emplace(dir, megabytes << 20);
+        error_code ec;
+        if (!filesystem::is_directory(dir, ec)) {
+            apiCache.reset();
+            return -1;
+        }
+        return 0;
+    } catch (...) {
+        return -1;
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+/* analyzer_api.h
+ *
+ * The three phases as a library with a C ABI, for callers that load the
+ * analyzer in-process (app.py does, through ctypes) instead of running
+ * ./analyzer. Build it with
+ *
+ *   g++ -std=c++17 -O2 -shared -fPIC -fvisibility=hidden -pthread analyzer_api.cpp -o libanalyzer.so
+ *
+ * Each call runs one mode (lexical, syntax, semantic or all) over a source
+ * buffer and returns what ./analyzer would write: the phase output when it
+ * succeeds, the diagnostics otherwise, in the format asked for (text, json or
+ * binary, see output.cpp). Results belong to the caller until they are passed
+ * to pva_free_result().
+ *
+ * Calls on different documents, and pva_analyze() calls, may run on any
+ * number of threads at once; one document takes one call at a time.
+ */
+#ifndef ANALYZER_API_H
+#define ANALYZER_API_H
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define PVA_API __attribute__((visibility("default")))
+#else
+#define PVA_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pva_result {
+    int status;        /* 0: data is the phase output; 1: data is the diagnostics */
+    size_t length;     /* bytes in data, not counting the terminating NUL */
+    const char* data;  /* binary output may contain NULs: use length */
+} pva_result;
+
+/* A source that is analyzed again and again as it changes. Only the part
+ * that changed since the previous call is lexed and parsed again. A
+ * document's memory stays proportional to its text however many calls it
+ * takes: what the edits leave behind is dropped by starting over with a full
+ * analysis once it could outweigh the rest, so a handle may be kept for the
+ * life of the caller. */
+typedef struct pva_document pva_document;
+
+/* One run over `length` bytes of `source`. `max_errors` is the run's error
+ * limit (0: no limit). Returns NULL if the run failed for any reason other
+ * than the source: memory ran out, or an unexpected internal error. */
+PVA_API pva_result* pva_analyze(const char* mode, const char* source, size_t length,
+                                const char* format, size_t max_errors);
+
+PVA_API pva_document* pva_document_new(void);
+
+/* Makes `source` the document's text and runs `mode` over it. Returns NULL
+ * under the same conditions as pva_analyze(). */
+PVA_API pva_result* pva_document_analyze(pva_document* doc, const char* mode, const char* source,
+                                         size_t length, const char* format, size_t max_errors);
+
+PVA_API void pva_document_free(pva_document* doc);
+
+PVA_API void pva_free_result(pva_result* result);
+
+/* Keeps finished runs in `dir` (created if missing), at most `megabytes` of
+ * them, and answers sources analyzed before from there; see cache.cpp. Call
+ * it before the first analysis. Returns 0, or -1 if `dir` is unusable. */
+PVA_API int pva_enable_cache(const char* dir, size_t megabytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
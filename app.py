@@ -1,10 +1,102 @@
-from flask import Flask, render_template, request
+from flask import Flask, Response, jsonify, render_template, request
+import ctypes
 import subprocess
-import tempfile
+import queue
 import os
 
 app = Flask(__name__, static_folder='static')
 
+BACKEND_DIR = 'backend'
+LIBRARY_PATH = 'libanalyzer.so'
+POOL_SIZE = int(os.environ.get('ANALYZER_WORKERS', '4'))
+MAX_ERRORS = int(os.environ.get('ANALYZER_MAX_ERRORS', '20'))
+# Result cache shared by the documents, relative to BACKEND_DIR; empty disables it.
+CACHE_DIR = os.environ.get('ANALYZER_CACHE', '.analyzer-cache')
+CACHE_MB = int(os.environ.get('ANALYZER_CACHE_MB', '256'))
+
+
+class _Result(ctypes.Structure):
+    _fields_ = [('status', ctypes.c_int), ('length', ctypes.c_size_t), ('data', ctypes.c_void_p)]
+
+
+def load_library():
+    """Builds libanalyzer.so if it is missing and loads it (analyzer_api.h).
+
+    Returns (library, None), or (None, the compiler error text).
+    """
+    path = os.path.join(BACKEND_DIR, LIBRARY_PATH)
+    if not os.path.exists(path):
+        compile_process = subprocess.run(
+            ['g++', '-std=c++17', '-O2', '-shared', '-fPIC', '-fvisibility=hidden', '-pthread',
+             'analyzer_api.cpp', '-o', LIBRARY_PATH],
+            cwd=BACKEND_DIR,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            text=True
+        )
+        if compile_process.returncode != 0:
+            return None, compile_process.stderr
+    lib = ctypes.CDLL(os.path.abspath(path))
+    lib.pva_document_new.restype = ctypes.c_void_p
+    lib.pva_document_new.argtypes = []
+    lib.pva_document_analyze.restype = ctypes.POINTER(_Result)
+    lib.pva_document_analyze.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p,
+                                         ctypes.c_size_t, ctypes.c_char_p, ctypes.c_size_t]
+    lib.pva_free_result.restype = None
+    lib.pva_free_result.argtypes = [ctypes.POINTER(_Result)]
+    lib.pva_enable_cache.restype = ctypes.c_int
+    lib.pva_enable_cache.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    if CACHE_DIR:
+        lib.pva_enable_cache(os.path.abspath(os.path.join(BACKEND_DIR, CACHE_DIR)).encode(), CACHE_MB)
+    return lib, None
+
+
+class AnalyzerDocument:
+    """One pva_document: the analyzer keeps the last source it was given and,
+    when the next one differs by a local change, re-lexes and re-parses only
+    around it. Sources analyzed before come back from the result cache.
+    A document takes one request at a time; ctypes releases the GIL for the
+    call, so documents in different threads run in parallel. Its memory stays
+    proportional to the last source (see analyzer_api.h), so the pool keeps
+    its documents for the life of the app.
+    """
+
+    def __init__(self, lib):
+        self.lib = lib
+        self.handle = lib.pva_document_new()
+        if not self.handle:
+            raise MemoryError('could not create an analyzer document')
+
+    def analyze(self, mode, code, output_format='text'):
+        source = code.encode('utf-8')
+        result = self.lib.pva_document_analyze(self.handle, mode.encode('ascii', 'replace'), source,
+                                                len(source), output_format.encode('ascii'), MAX_ERRORS)
+        if not result:
+            raise RuntimeError('analyzer failed')
+        try:
+            r = result.contents
+            payload = ctypes.string_at(r.data, r.length).decode('utf-8', errors='replace')
+            return r.status == 0, payload
+        finally:
+            self.lib.pva_free_result(result)
+
+
+# The library is built and loaded when the app starts, not on a request.
+_library, _library_error = load_library()
+_pool = queue.Queue()
+if _library:
+    for _ in range(POOL_SIZE):
+        _pool.put(AnalyzerDocument(_library))
+
+
+def run_analyzer(mode, code, output_format='text'):
+    document = _pool.get()
+    try:
+        return document.analyze(mode, code, output_format)
+    finally:
+        _pool.put(document)
+
+
 @app.route('/', methods=['GET', 'POST'])
 def index():
     output = ""
@@ -15,35 +107,30 @@ def index():
         code = request.form['code']
         selected_phase = request.form['phase']
 
-        with tempfile.NamedTemporaryFile(delete=False, suffix=".cpp", mode='w') as tmp:
-            tmp.write(code)
-            tmp_path = tmp.name
-
-        binary_path = './analyzer'
-        if not os.path.exists(binary_path):
-            compile_process = subprocess.run(
-                ['g++', 'analyzer.cpp', '-o', binary_path],
-                cwd='backend',
-                stdout=subprocess.PIPE,
-                stderr=subprocess.PIPE,
-                text=True
-            )
-            if compile_process.returncode != 0:
-                output = compile_process.stderr
-                return render_template('index.html', code=code, output=output, phase=selected_phase)
-
-        run_process = subprocess.run(
-            [binary_path, selected_phase, tmp_path],
-            cwd='backend',
-            stdout=subprocess.PIPE,
-            stderr=subprocess.PIPE,
-            text=True
-        )
+        if _library_error:
+            return render_template('index.html', code=code, output=_library_error, phase=selected_phase)
 
-        output = run_process.stdout if run_process.returncode == 0 else run_process.stderr
-        os.remove(tmp_path)
+        _, output = run_analyzer(selected_phase, code)
 
     return render_template('index.html', code=code, output=output, phase=selected_phase)
 
+
+@app.route('/api/analyze', methods=['POST'])
+def api_analyze():
+    """JSON in ({"code": ..., "phase": ...}), the analyzer's JSON document out.
+
+    Successful runs answer 200 with tokens/ast/symbols as the phase produces
+    them; failed runs answer 422 with {"errors": [...], "limitReached": ...}.
+    """
+    body = request.get_json(silent=True) or {}
+    code = body.get('code', '')
+    phase = body.get('phase', 'all')
+
+    if _library_error:
+        return jsonify(errors=[_library_error], limitReached=False), 500
+
+    ok, output = run_analyzer(phase, code, 'json')
+    return Response(output, status=200 if ok else 422, mimetype='application/json')
+
 if __name__ == '__main__':
     app.run(debug=True)
@@ -0,0 +1,1431 @@
+// benchmark.cpp — standalone performance harness for the analyzer phases.
+//
+//   g++ -O2 -pthread benchmark.cpp -o benchmark
+//   ./benchmark [size_mb]                           everything
+//   ./benchmark --suite [size_mb]                   the corpus suite only
+//   ./benchmark --depth                             the nesting-depth benchmark only
+//   ./benchmark --expr [operands]                   the flat-expression benchmark only
+//   ./benchmark --corpus <shape> [size_mb] [unit]   write a generated input to stdout
+//
+#include <bits/stdc++.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include "pipeline.cpp"  // Includes cache.cpp → output.cpp → semantic.cpp → syntax.cpp → lexical.cpp
+#include "allocations.cpp"  // every operator new feeds allocationCount
+using namespace std;
+
+// ————————————————————————————— Reference Lexer —————————————————————————————
+// The regex/hash-set tokenizer that tokenize() replaced, kept verbatim so the
+// table-driven scanner can be measured (and cross-checked) against it.
+namespace legacy {
+
+struct token {
+    tokenType type;
+    string value;
+    int line;
+    int col;
+};
+
+unordered_set<string>keywords = {"int","float","double","long long","char","bool","string","if","else","for","while","true","false","return",
+                                "void","break","continue","switch","case","default","cout","cin","using","namespace"
+};
+
+unordered_set<char>operators = {'+','-','*','/','=','%','&','|','<','>','!','^'};
+
+unordered_set<char>separators = {'{' , '}' , ',' , '[' , ']' , '(' , ')' , ':' , ';' };
+
+bool isNumber(const string &str) {
+    return regex_match(str,regex("-?([0-9]+(\\.[0-9]+)?|\\.[0-9]+)"));
+}
+
+bool isIdentitfier(const string& str) {
+    return regex_match(str,regex("[_a-zA-Z]+[_a-zA-Z0-9]*"));
+}
+
+vector<token> tokenize(const string &code) {
+    vector<token>tokens;
+    int i=0;
+    int len = code.length();
+    int line = 1;
+    int column = 1;
+    while(i < len) {
+        char c = code[i];
+        if (c == '#') {
+            int start = i;
+            while (i < len && code[i] != '\n') i++;
+            string val = code.substr(start, i - start-1);
+            tokens.push_back({tokenType::preprocessor, val, line, column});
+            column += (i - start);
+            continue;
+        }
+        if(isspace(c)) {
+            if(c == '\n') {
+                line++;
+                column = 1;
+            }
+            else {
+                column++;
+            }
+            i++;
+            continue;
+        }
+        if(c == '/' && i+1<len && code[i+1] =='/') {
+            i+=2;
+            while(i < len && code[i] != '\n')
+                i++;
+            line++;
+            column = 1;
+            i++;
+            continue;
+        }
+        if(c == '/' && i+1<len && code[i+1] == '*') {
+            i+=2;
+            column+=2;
+            while(i+1<len && !(code[i] == '*' && code[i+1] == '/')) {
+                if(code[i] == '\n') {
+                    line++;
+                    column = 1;
+                }
+                else
+                    column++;
+                i++;
+            }
+            i+=2;
+            column+=2;
+            continue;
+        }
+        if(c == '"') {
+            i++;
+            int start = i;
+            while(i < len && code[i] != '"')
+                i++;
+            i++;
+            tokens.push_back({tokenType::stringtype,code.substr(start,i-start-1),line,column});
+            column += (i-start);
+            continue;
+        }
+        if (operators.count(c)) {
+            string op(1, c);
+            if (i + 1 < len) {
+                char next = code[i + 1];
+                if ((c == '<' && next == '<') || (c == '>' && next == '>') ||
+                    (c == '<' && next == '=') || (c == '>' && next == '=') ||
+                    (c == '=' && next == '=') || (c == '!' && next == '=')) {
+                    op += next;
+                    i++;
+                }
+            }
+            tokens.push_back({tokenType::operaTor, op, line, column});
+            column += op.length();
+            i++;
+            continue;
+        }
+        if(separators.count(c)) {
+            tokens.push_back({tokenType::separator,string(1,c),line,column});
+            column++;
+            i++;
+            continue;
+        }
+        if(isalnum(c) || c == '_' || c == '.') {
+            int start = i;
+            while(i < len && (isalnum(code[i]) || code[i] =='_' || code[i] == '.'))
+                i++;
+            string val = code.substr(start,i-start);
+            tokenType type;
+            if(keywords.count(val))
+                type = tokenType::keyword;
+            else if(isNumber(val))
+                type = tokenType::number;
+            else if(isIdentitfier(val))
+                type = tokenType::identifier;
+            else
+                type = tokenType::unknown;
+            tokens.push_back({type,val,line,column});
+            column += (i-start);
+            continue;
+        }
+        tokens.push_back({tokenType::unknown,string(1,c),line,column});
+        i++;
+        column++;
+    }
+    return tokens;
+}
+
+// The scope layout SemanticAnalyzer used before ScopedSymbolTable: one
+// std::map per open scope, searched innermost → outermost.
+struct scopeStack {
+    vector<map<string, int>> scopes{1};
+
+    void pushScope() { scopes.emplace_back(); }
+    void popScope() { scopes.pop_back(); }
+    void declare(const string& name, int symbol) { scopes.back()[name] = symbol; }
+
+    int lookup(const string& name) {
+        for (int i = (int)scopes.size() - 1; i >= 0; --i) {
+            auto it = scopes[i].find(name);
+            if (it != scopes[i].end()) return it->second;
+        }
+        return -1;
+    }
+};
+
+// The comparison → expression → term → factor cascade that the operator
+// table replaced, one function per tier, widened to the tiers of
+// binaryOperators (without comparisons) so both parse the same expressions
+// into the same nodes. `calls` counts the tier functions entered.
+struct cascadeParser {
+    const vector<::token>& tokens;
+    const Interner& names;
+    Arena& arena;
+    int current = 0;
+    long calls = 0;
+
+    static constexpr int operandTier = 8;
+
+    int tierOf(const ::token& t) const {
+        if (t.type != operaTor || t.id >= fixedSymbolCount || binaryOperators[t.id].comparison)
+            return 0;
+        return binaryOperators[t.id].precedence;
+    }
+
+    ASTNode* leaf(nodeKind kind, const ::token& t, ASTNode* left = nullptr, ASTNode* right = nullptr) {
+        ASTNode** kids = nullptr;
+        if (left) {
+            kids = (ASTNode**)arena.allocate(2 * sizeof(ASTNode*), alignof(ASTNode*));
+            kids[0] = left;
+            kids[1] = right;
+        }
+        string_view value = t.id != Interner::none ? names.name(t.id) : arena.copy(t.value);
+        return arena.make<ASTNode>(kind, left ? 2u : 0u, t.line, t.col, t.id, kids, value);
+    }
+
+    ASTNode* tier(int level) {
+        calls++;
+        if (level == operandTier) {
+            const ::token& t = tokens[current];
+            if (t.type == separator && t.id == sepLParen) {
+                current++;
+                ASTNode* inner = tier(1);
+                current++;  // ')'
+                return inner;
+            }
+            current++;
+            return leaf(t.type == number ? astNumber : astIdentifier, t);
+        }
+        ASTNode* left = tier(level + 1);
+        while (current < (int)tokens.size() && tierOf(tokens[current]) == level) {
+            const ::token& op = tokens[current++];
+            left = leaf(astBinary, op, left, tier(level + 1));
+        }
+        return left;
+    }
+};
+
+// ————————————————————————————— Reference Parser —————————————————————————————
+// The recursive-descent Parser before the token view and the arena AST, kept
+// verbatim but for parse() not printing the tree: it copies the token vector,
+// returns tokens by value from peek(), peekNext() and advance(), and builds
+// std::string-valued nodes with new.
+// Define the AST node structure
+struct ASTNode {
+    string type;
+    vector<ASTNode*> children;
+    string value;
+    ASTNode(string t, vector<ASTNode*> c = {}, string v = "") 
+      : type(t), children(c), value(v) {}
+};
+
+class Parser {
+    vector<token> tokens;
+    int current = 0;
+    ASTNode* root; // Root of the AST
+
+public:
+    Parser(const vector<token>& t) : tokens(t), root(nullptr) {}
+
+    void parse() {
+        root = new ASTNode{"program"};
+        while (!isAtEnd()) {
+            ASTNode* stmt = statement();
+            if (stmt) 
+                root->children.push_back(stmt);
+        }
+    }
+
+private:
+    // Basic token utilities
+    token peek() {
+        return (current < (int)tokens.size())
+               ? tokens[current]
+               : token{ unknown, "", -1, -1 };
+    }
+
+    token peekNext(int offset = 1) {
+        int idx = current + offset;
+        if (idx < (int)tokens.size()) 
+            return tokens[idx];
+        return token{ unknown, "", -1, -1 };
+    }
+
+    token advance() {
+        return tokens[current++];
+    }
+
+    bool match(tokenType type, const string& val = "") {
+        if (current >= (int)tokens.size()) 
+            return false;
+        if (tokens[current].type == type &&
+            (val.empty() || tokens[current].value == val)) 
+        {
+            current++;
+            return true;
+        }
+        return false;
+    }
+
+    bool check(tokenType type, const string& val = "") {
+        if (isAtEnd()) 
+            return false;
+        return (tokens[current].type == type) &&
+               (val.empty() || tokens[current].value == val);
+    }
+
+    bool isAtEnd() {
+        return current >= (int)tokens.size();
+    }
+
+    void error(const string& msg) {
+        token t = peek();
+        if (t.line == -1) {
+            cerr << "Syntax Error: " << msg << " (unexpected end of input)\n";
+        } else {
+            cerr << "Syntax Error at line " << t.line 
+                 << ", column " << t.col << ": " << msg << "\n";
+        }
+        exit(1);
+    }
+
+    void expect(const string& symbol, const string& errMsg) {
+        if (!match(operaTor, symbol) && !match(separator, symbol)) {
+            error(errMsg);
+        }
+    }
+
+    bool isValidTypeKeyword() {
+        return check(keyword, "int") || check(keyword, "float") ||
+               check(keyword, "char") || check(keyword, "bool");
+    }
+
+    // Modified parsing functions to return ASTNode*
+    ASTNode* statement() {
+        // 1) Skip any preprocessor directive entirely:
+        if (check(preprocessor)) {
+            advance();
+            return nullptr;
+        }
+
+        // 2) Function declaration (e.g., "int foo()" or "void bar()")
+        if ((check(keyword, "int") || check(keyword, "void")) &&
+            peekNext().type == identifier &&
+            peekNext(2).type == separator && peekNext(2).value == "(") 
+        {
+            return function_decl();
+        }
+
+        // 3) using namespace std;
+        if (match(keyword, "using")) {
+            if (!match(keyword, "namespace")) 
+                error("Expected 'namespace' after 'using'");
+            if (!match(identifier, "std")) 
+                error("Expected 'std' after 'namespace'");
+            expect(";", "Expected ';' after using namespace std");
+            return nullptr; // ignore this in the AST
+        }
+
+        // 4) Block: "{ ... }"
+        if (check(separator, "{")) {
+            return block();
+        }
+
+        // 5) Declaration: e.g., "int x;" or "float y = 3;"
+        if (isValidTypeKeyword()) {
+            ASTNode* decl = declaration();
+            expect(";", "Expected ';' after declaration.");
+            return decl;
+        }
+
+        // 6) if-statement
+        if (check(keyword, "if")) {
+            return if_stmt();
+        }
+
+        // 7) while-statement
+        if (check(keyword, "while")) {
+            return while_stmt();
+        }
+
+        // 8) for-statement
+        if (check(keyword, "for")) {
+            return for_stmt();
+        }
+
+        // 9) cout-statement
+        if (check(keyword, "cout")) {
+            advance(); // consume 'cout'
+            ASTNode* coutNode = cout_stmt();
+            expect(";", "Expected ';' after cout statement.");
+            return coutNode;
+        }
+
+        // 10) cin-statement
+        if (check(keyword, "cin")) {
+            advance(); // consume 'cin'
+            ASTNode* cinNode = cin_stmt();
+            expect(";", "Expected ';' after cin statement.");
+            return cinNode;
+        }
+
+        // 11) return-statement
+        if (check(keyword, "return")) {
+            return return_stmt();
+        }
+
+        // 12) assignment (identifier = expression;)
+        if (check(identifier) && peekNext().type == operaTor && peekNext().value == "=") {
+            ASTNode* assign = assignment();
+            expect(";", "Expected ';' after assignment.");
+            return assign;
+        }
+
+        // 13) Standalone semicolon or unknown separators can be skipped
+        if (check(separator, ";")) {
+            advance();
+            return nullptr;
+        }
+
+        // 14) If we reach here and it's not the end, it's an unknown statement
+        error("Unknown statement");
+        return nullptr;
+    }
+
+    ASTNode* block() {
+        expect("{", "Expected '{' to begin block.");
+        ASTNode* blockNode = new ASTNode{"block"};
+        // Collect statements until matching "}"
+        while (!check(separator, "}") && !isAtEnd()) {
+            ASTNode* stmt = statement();
+            if (stmt) 
+                blockNode->children.push_back(stmt);
+        }
+        expect("}", "Expected '}' to close block.");
+        return blockNode;
+    }
+
+    ASTNode* cout_stmt() {
+        ASTNode* coutNode = new ASTNode{"cout"};
+        if (!match(operaTor, "<<")) 
+            error("Expected '<<' after 'cout'");
+        ASTNode* val = cout_value();
+        coutNode->children.push_back(val);
+        while (match(operaTor, "<<")) {
+            val = cout_value();
+            coutNode->children.push_back(val);
+        }
+        return coutNode;
+    }
+
+    ASTNode* cin_stmt() {
+        ASTNode* cinNode = new ASTNode{"cin"};
+        if (!match(operaTor, ">>")) 
+            error("Expected '>>' after 'cin'");
+        if (!match(identifier)) 
+            error("Expected identifier after '>>'");
+        cinNode->children.push_back(new ASTNode{"identifier", {}, tokens[current-1].value});
+        while (match(operaTor, ">>")) {
+            if (!match(identifier)) 
+                error("Expected identifier after '>>'");
+            cinNode->children.push_back(new ASTNode{"identifier", {}, tokens[current-1].value});
+        }
+        return cinNode;
+    }
+
+    ASTNode* cout_value() {
+        if (match(stringtype)) {
+            return new ASTNode{"string", {}, tokens[current-1].value};
+        }
+        else if (match(identifier)) {
+            return new ASTNode{"identifier", {}, tokens[current-1].value};
+        }
+        else if (match(number)) {
+            return new ASTNode{"number", {}, tokens[current-1].value};
+        }
+        else {
+            error("Expected string, identifier, or number in cout");
+            return nullptr;
+        }
+    }
+
+    ASTNode* return_stmt() {
+        match(keyword, "return");
+        ASTNode* returnNode = new ASTNode{"return"};
+        if (!check(separator, ";")) {
+            ASTNode* expr = expression();
+            returnNode->children.push_back(expr);
+        }
+        expect(";", "Expected ';' after return statement.");
+        return returnNode;
+    }
+
+    ASTNode* declaration() {
+        string typeStr = peek().value;
+        type();
+        if (!match(identifier)) 
+            error("Expected identifier in declaration.");
+        string id = tokens[current-1].value;
+        ASTNode* declNode = new ASTNode{"declaration"};
+        declNode->children.push_back(new ASTNode{"type", {}, typeStr});
+        declNode->children.push_back(new ASTNode{"identifier", {}, id});
+        if (match(operaTor, "=")) {
+            ASTNode* expr = expression();
+            declNode->children.push_back(expr);
+        }
+        return declNode;
+    }
+
+    ASTNode* assignment() {
+        if (!match(identifier)) 
+            error("Expected identifier in assignment.");
+        string id = tokens[current-1].value;
+        expect("=", "Expected '=' in assignment.");
+        ASTNode* expr = expression();
+        ASTNode* assignNode = new ASTNode{"assignment"};
+        assignNode->children.push_back(new ASTNode{"identifier", {}, id});
+        assignNode->children.push_back(expr);
+        return assignNode;
+    }
+
+    ASTNode* if_stmt() {
+        match(keyword, "if");
+        expect("(", "Expected '(' after 'if'.");
+        ASTNode* condition = comparison();
+        expect(")", "Expected ')' after condition.");
+        ASTNode* thenStmt = statement();
+        ASTNode* ifNode = new ASTNode{"if"};
+        ifNode->children.push_back(condition);
+        ifNode->children.push_back(thenStmt);
+        if (match(keyword, "else")) {
+            ASTNode* elseStmt = statement();
+            ifNode->children.push_back(elseStmt);
+        }
+        return ifNode;
+    }
+
+    ASTNode* while_stmt() {
+        match(keyword, "while");
+        expect("(", "Expected '(' after 'while'.");
+        ASTNode* condition = comparison();
+        expect(")", "Expected ')' after condition.");
+        ASTNode* body = statement();
+        ASTNode* whileNode = new ASTNode{"while"};
+        whileNode->children.push_back(condition);
+        whileNode->children.push_back(body);
+        return whileNode;
+    }
+
+    ASTNode* for_stmt() {
+        match(keyword, "for");
+        expect("(", "Expected '(' after 'for'.");
+        ASTNode* init = assignment();
+        expect(";", "Expected ';' after init assignment.");
+        ASTNode* condition = comparison();
+        expect(";", "Expected ';' after loop condition.");
+        ASTNode* increment = assignment();
+        expect(")", "Expected ')' after increment.");
+        ASTNode* body = statement();
+        ASTNode* forNode = new ASTNode{"for"};
+        forNode->children.push_back(init);
+        forNode->children.push_back(condition);
+        forNode->children.push_back(increment);
+        forNode->children.push_back(body);
+        return forNode;
+    }
+
+    ASTNode* comparison() {
+        ASTNode* left = expression();
+        while (match(operaTor, "<") || match(operaTor, ">") ||
+               match(operaTor, "==") || match(operaTor, "!=") ||
+               match(operaTor, "<=") || match(operaTor, ">=")) 
+        {
+            string op = tokens[current-1].value;
+            ASTNode* right = expression();
+            ASTNode* compNode = new ASTNode{"comparison", {left, right}, op};
+            left = compNode;
+        }
+        return left;
+    }
+
+    ASTNode* expression() {
+        ASTNode* left = term();
+        while (match(operaTor, "+") || match(operaTor, "-")) {
+            string op = tokens[current-1].value;
+            ASTNode* right = term();
+            left = new ASTNode{"binary", {left, right}, op};
+        }
+        return left;
+    }
+
+    ASTNode* term() {
+        ASTNode* left = factor();
+        while (match(operaTor, "*") || match(operaTor, "/")) {
+            string op = tokens[current-1].value;
+            ASTNode* right = factor();
+            left = new ASTNode{"binary", {left, right}, op};
+        }
+        return left;
+    }
+
+    ASTNode* factor() {
+        if (match(number)) {
+            return new ASTNode{"number", {}, tokens[current-1].value};
+        }
+        else if (match(identifier)) {
+            return new ASTNode{"identifier", {}, tokens[current-1].value};
+        }
+        else if (match(separator, "(")) {
+            ASTNode* expr = expression();
+            expect(")", "Expected ')' after expression.");
+            return expr;
+        }
+        else {
+            error("Expected number, identifier or '('");
+            return nullptr;
+        }
+    }
+
+    ASTNode* function_decl() {
+        string returnType = peek().value;
+        type();
+        if (!match(identifier)) 
+            error("Expected function name after return type");
+        string funcName = tokens[current-1].value;
+        expect("(", "Expected '(' after function name");
+        expect(")", "Expected ')' after function parameters");
+        ASTNode* body = block();
+        ASTNode* funcNode = new ASTNode{"function"};
+        funcNode->children.push_back(new ASTNode{"returnType", {}, returnType});
+        funcNode->children.push_back(new ASTNode{"identifier", {}, funcName});
+        funcNode->children.push_back(body);
+        return funcNode;
+    }
+
+    void type() {
+        if (!(match(keyword, "int")   ||
+              match(keyword, "float") ||
+              match(keyword, "char")  ||
+              match(keyword, "bool")  ||
+              match(keyword, "void"))) 
+        {
+            error("Expected type (int, float, char, bool, void)");
+        }
+    }
+};
+
+} // namespace legacy
+
+// ————————————————————————————— Input Generation —————————————————————————————
+// Repeats a representative function with fresh identifiers until `bytes` is reached.
+string makeSource(size_t bytes) {
+    string code = "#include <iostream>\nusing namespace std;\n";
+    for (int n = 0; code.size() < bytes; n++) {
+        string k = to_string(n);
+        code += "// function " + k + "\n"
+                "int f" + k + "() {\n"
+                "    int a" + k + " = " + k + ";\n"
+                "    float b" + k + " = 2.5;\n"
+                "    /* update the running\n"
+                "       values */\n"
+                "    if (a" + k + " <= 10) {\n"
+                "        a" + k + " = a" + k + " + 1;\n"
+                "    }\n"
+                "    while (a" + k + " != 0) { a" + k + " = a" + k + " - 1; }\n"
+                "    cout << \"value: \" << a" + k + " << b" + k + ";\n"
+                "    return (a" + k + " + 2) * 3;\n"
+                "}\n";
+    }
+    return code;
+}
+
+// Mostly comments, indentation and string literals: the input the scan
+// kernels are for.
+string makeCommentedSource(size_t bytes) {
+    string code;
+    for (int n = 0; code.size() < bytes; n++) {
+        string k = to_string(n);
+        code += "/*\n"
+                " * Section " + k + ". The block below keeps the running totals up to date;\n"
+                " * every branch is documented at length so readers need not guess what\n"
+                " * the state looks like before and after each step of the update.\n"
+                " */\n"
+                "int g" + k + "() {\n"
+                "        // first, load the value that the previous section left behind us\n"
+                "        int a" + k + " = " + k + ";\n"
+                "                // then print it, with a label long enough to matter here\n"
+                "        cout << \"the running total after this section is now: \" << a" + k + ";\n"
+                "        return a" + k + ";\n"
+                "}\n\n";
+    }
+    return code;
+}
+
+// ————————————————————————————— Corpus Generator —————————————————————————————
+// Deterministic inputs in the subset Parser accepts, one shape per stress
+// point, each repeated until `bytes` is reached. Every program is free of
+// syntax and semantic errors, so all three phases do their full work. The
+// shape parameter (`size`) sets how deep, long or big one unit is.
+struct corpusShape {
+    const char* name;
+    const char* stresses;
+    int size;                                 // default unit size
+    string (*unit)(int n, int size);          // the n-th unit
+};
+
+// Globals and locals, each initialized from the ones before it.
+string declarationsUnit(int n, int size) {
+    string k = to_string(n), code = "int g" + k + " = " + k + ";\nint decl" + k + "() {\n";
+    for (int i = 0; i < size; i++) {
+        string v = "d" + k + "_" + to_string(i);
+        string prev = i ? "d" + k + "_" + to_string(i - 1) : "g" + k;
+        code += "    " + string(i % 2 ? "float " : "int ") + v + " = " + prev + " * 2 + " + to_string(i) + ";\n";
+    }
+    return code + "    return g" + k + ";\n}\n";
+}
+
+// Blocks, ifs and whiles nested `size` deep, each level declaring a name.
+string nestingUnit(int n, int size) {
+    string k = to_string(n), code = "int nest" + k + "() {\n    int n" + k + "_0 = " + k + ";\n";
+    for (int d = 0; d < size; d++) {
+        string v = "n" + k + "_" + to_string(d);
+        const char* open[] = { "if (", "while (", "{" };
+        int form = d % 3;
+        code += string(4 + (d % 16) * 2, ' ') + open[form];
+        if (form < 2) code += v + " < " + to_string(d + 100) + ") {";
+        code += " int n" + k + "_" + to_string(d + 1) + " = " + v + " + 1;\n";
+    }
+    return code + string(size, '}') + "\n    return 0;\n}\n";
+}
+
+// cout statements with `size` operands each.
+string coutUnit(int n, int size) {
+    string k = to_string(n), code = "void print" + k + "() {\n    int c" + k + " = " + k + ";\n    cout";
+    for (int i = 0; i < size; i++) {
+        if (i % 3 == 0) code += " << \"item \"";
+        else if (i % 3 == 1) code += " << c" + k;
+        else code += " << " + to_string(i);
+        if (i % 8 == 7) code += "\n        ";
+    }
+    return code + ";\n}\n";
+}
+
+// A `size`-line block comment and a run of line comments per declaration.
+string commentsUnit(int n, int size) {
+    string k = to_string(n), code = "/*\n";
+    for (int i = 0; i < size; i++)
+        code += " * Line " + to_string(i) + " of the notes on section " + k + "; nothing here is code.\n";
+    code += " */\n";
+    for (int i = 0; i < size / 4; i++)
+        code += "// remark " + to_string(i) + " about the declaration below\n";
+    return code + "int comment" + k + " = " + k + ";\n";
+}
+
+// One function of `size` statements of every kind.
+string hugeFunctionUnit(int n, int size) {
+    string k = to_string(n), code = "int huge" + k + "() {\n    int h" + k + " = 0;\n    float f" + k + " = 1.5;\n";
+    string h = "h" + k, f = "f" + k;
+    for (int i = 0; i < size; i++) {
+        string c = to_string(i);
+        switch (i % 6) {
+        case 0: code += "    " + h + " = " + h + " + " + c + " * (" + h + " - 1);\n"; break;
+        case 1: code += "    if (" + h + " > " + c + ") { " + h + " = " + h + " - 1; } else { " + f + " = " + f + " / 2; }\n"; break;
+        case 2: code += "    while (" + h + " != " + c + ") { " + h + " = " + c + "; }\n"; break;
+        case 3: code += "    for (" + h + " = 0; " + h + " < " + c + "; " + h + " = " + h + " + 1) " + f + " = " + f + " + 1;\n"; break;
+        case 4: code += "    cout << \"step \" << " + h + " << " + f + ";\n"; break;
+        case 5: code += "    { int t" + c + " = " + h + " + " + c + "; " + h + " = t" + c + "; }\n"; break;
+        }
+    }
+    return code + "    return " + h + ";\n}\n";
+}
+
+const corpusShape corpusShapes[] = {
+    { "declarations", "many declarations and lookups", 200, declarationsUnit },
+    { "nesting", "deeply nested blocks and scopes", 200, nestingUnit },
+    { "cout", "long cout << chains", 400, coutUnit },
+    { "comments", "big comment blocks", 200, commentsUnit },
+    { "huge-function", "one very long function body", 20000, hugeFunctionUnit },
+};
+
+const corpusShape* findCorpusShape(const string& name) {
+    for (const corpusShape& s : corpusShapes)
+        if (name == s.name) return &s;
+    return nullptr;
+}
+
+string makeCorpus(const corpusShape& shape, size_t bytes, int size = 0) {
+    string code = "#include <iostream>\nusing namespace std;\n";
+    for (int n = 0; code.size() < bytes; n++)
+        code += shape.unit(n, size ? size : shape.size);
+    return code;
+}
+
+// ————————————————————————————— Timing —————————————————————————————
+// Results nobody reads are stored here so the optimizer keeps the work.
+volatile long benchSink;
+
+// Best-of-`reps` wall time in seconds.
+template <class F>
+double bestOf(int reps, F&& fn) {
+    double best = 1e100;
+    for (int r = 0; r < reps; r++) {
+        auto t0 = chrono::steady_clock::now();
+        fn();
+        auto t1 = chrono::steady_clock::now();
+        best = min(best, chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+// One hardware event counted for this thread, user space only. `ok` is false
+// where the kernel or the sandbox does not offer the counter.
+struct perfCounter {
+    int fd = -1;
+
+    explicit perfCounter(uint64_t event) {
+        perf_event_attr attr{};
+        attr.size = sizeof attr;
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = event;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~perfCounter() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool ok() const { return fd >= 0; }
+
+    // Events while fn() runs.
+    template <class F>
+    long count(F&& fn) {
+        long n = 0;
+        if (ok()) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        fn();
+        if (ok()) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &n, sizeof n) != sizeof n) n = 0;
+        }
+        return n;
+    }
+};
+
+void report(const string& name, size_t bytes, double secs) {
+    printf("%-28s %10.3f ms %10.1f MB/s\n", name.c_str(), secs * 1e3, bytes / secs / 1e6);
+}
+
+// ————————————————————————————— Benchmarks —————————————————————————————
+void benchLexer(const string& code) {
+    // The regex lexer is slow enough that a single run is plenty.
+    vector<legacy::token> a;
+    vector<token> b;
+    double tLegacy = bestOf(1, [&] { a = legacy::tokenize(code); });
+    double tTable  = bestOf(5, [&] {
+        Interner names;
+        b = tokenize(code, names);
+    });
+
+    // The two scanners must agree token-for-token.
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); i++)
+        same = a[i].type == b[i].type && a[i].value == b[i].value &&
+               a[i].line == b[i].line && a[i].col == b[i].col;
+
+    printf("== tokenize(): %zu bytes, %zu tokens (%s)\n", code.size(), b.size(),
+           same ? "outputs identical" : "OUTPUTS DIFFER");
+    report("regex + hash sets", code.size(), tLegacy);
+    report("class table + perfect hash", code.size(), tTable);
+    printf("%-28s %10.1fx\n", "speedup", tLegacy / tTable);
+
+    // Token vector footprint: the old tokens also own one heap string each
+    // once the value outgrows the small-string buffer.
+    size_t legacyHeap = 0;
+    for (auto& t : a)
+        if (t.value.capacity() > 15) legacyHeap += t.value.capacity() + 1;
+    printf("%-28s %10zu B/token (+%zu B heap)\n", "owning string tokens", sizeof(legacy::token), legacyHeap);
+    printf("%-28s %10zu B/token\n", "string_view tokens", sizeof(token));
+}
+
+// tokenize() on comment-heavy input with each set of scan kernels, in bytes
+// per TSC cycle. The scalar kernels are the byte-at-a-time loops.
+void benchScanKernels(size_t bytes) {
+    string code = makeCommentedSource(bytes);
+    const scanKernels* chosen = scan;
+    vector<const scanKernels*> sets{ &scalarKernels };
+#ifdef __SSE2__
+    sets.push_back(&sse2Kernels);
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) sets.push_back(&avx2Kernels);
+#endif
+
+    printf("== scan kernels: %zu bytes of comment-heavy code (runtime pick: %s)\n", code.size(), chosen->name);
+    printf("%-28s %10s %10s %10s\n", "kernels", "ms", "MB/s", "B/cycle");
+    vector<token> base;
+    for (const scanKernels* k : sets) {
+        scan = k;
+        vector<token> toks;
+        double best = 1e100;
+        uint64_t cycles = 0;
+        for (int r = 0; r < 5; r++) {
+            Interner names;
+            auto t0 = chrono::steady_clock::now();
+            uint64_t c0 = __rdtsc();
+            toks = tokenize(code, names);
+            uint64_t c1 = __rdtsc();
+            double t = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            if (t < best) best = t, cycles = c1 - c0;
+        }
+        if (base.empty()) base = toks;
+        bool same = toks.size() == base.size();
+        for (size_t i = 0; same && i < toks.size(); i++)
+            same = toks[i].type == base[i].type && toks[i].value == base[i].value &&
+                   toks[i].line == base[i].line && toks[i].col == base[i].col;
+        printf("%-28s %10.3f %10.1f %10.3f%s\n", k->name, best * 1e3, code.size() / best / 1e6,
+               (double)code.size() / cycles, same ? "" : "  OUTPUTS DIFFER");
+    }
+    scan = chosen;
+}
+
+// tokenizeParallel() on 1 … N threads against the single-threaded tokenize().
+// N is the hardware thread count, but at least 8 so the overhead shows too.
+void benchParallelLexer(const string& code) {
+    unsigned hw = max(1u, thread::hardware_concurrency());
+    Interner seqNames;
+    vector<token> seq;
+    double tSeq = bestOf(5, [&] {
+        Interner names;
+        seq = tokenize(code, names);
+    });
+    tokenize(code, seqNames);
+
+    printf("== tokenizeParallel(): %zu bytes, %u hardware threads\n", code.size(), hw);
+    printf("%-28s %10s %10s %10s\n", "threads", "ms", "MB/s", "speedup");
+    printf("%28s %10.3f %10.1f %9.2fx\n", "tokenize()", tSeq * 1e3, code.size() / tSeq / 1e6, 1.0);
+    for (unsigned threads = 1; threads <= max(8u, hw); threads *= 2) {
+        Interner names;
+        vector<token> par;
+        double t = bestOf(5, [&] {
+            Interner fresh;
+            par = tokenizeParallel(code, fresh, threads);
+        });
+        par = tokenizeParallel(code, names, threads);
+        bool same = par.size() == seq.size() && names.size() == seqNames.size();
+        for (size_t i = 0; same && i < par.size(); i++)
+            same = par[i].type == seq[i].type && par[i].id == seq[i].id && par[i].value == seq[i].value &&
+                   par[i].line == seq[i].line && par[i].col == seq[i].col;
+        printf("%28u %10.3f %10.1f %9.2fx%s\n", threads, t * 1e3, code.size() / t / 1e6, tSeq / t,
+               same ? "" : "  OUTPUTS DIFFER");
+    }
+}
+
+// One small edit at a few positions: relex() against a full tokenize() of the
+// edited text. The rescan follows the edit; what remains proportional to the
+// file is the pass that rebases and shifts the reused tokens.
+void benchIncrementalLex(const string& code) {
+    Interner names;
+    vector<token> base = tokenize(code, names);
+    printf("== relex(): one edit in %zu tokens\n", base.size());
+    printf("%-28s %12s %12s %12s\n", "edit position", "relex() ms", "full ms", "rescanned");
+    for (double at : {0.1, 0.5, 0.9}) {
+        textEdit e{ (size_t)(code.size() * at), 1, "y + 1" };
+        string edited = applyEdit(code, e);
+
+        vector<token> toks;
+        size_t scanned = 0;
+        double tRelex = 1e100;
+        for (int r = 0; r < 5; r++) {
+            toks = base;  // relex() updates in place; the copy is not timed
+            tRelex = min(tRelex, bestOf(1, [&] { scanned = relex(toks, code, edited, e, names).inserted; }));
+        }
+        vector<token> full;
+        double tFull = bestOf(3, [&] { full = tokenize(edited, names); });
+
+        bool same = full.size() == toks.size();
+        for (size_t i = 0; same && i < full.size(); i++)
+            same = full[i].type == toks[i].type && full[i].value == toks[i].value &&
+                   full[i].line == toks[i].line && full[i].col == toks[i].col;
+        printf("%27.0f%% %12.3f %12.3f %12zu%s\n", at * 100, tRelex * 1e3, tFull * 1e3, scanned,
+               same ? "" : "  OUTPUTS DIFFER");
+    }
+}
+
+// The same edits once more, now also bringing the tree up to date:
+// Parser::reparse() of the touched function against a fresh parse().
+void benchIncrementalParse(const string& code) {
+    printf("== reparse(): one edit inside a function\n");
+    printf("%-28s %12s %12s %12s\n", "edit position", "reparse() ms", "parse() ms", "same tree");
+    for (double at : {0.1, 0.5, 0.9}) {
+        // Edit the first initializer of the function at that position.
+        size_t fn = code.find("int f", (size_t)(code.size() * at));
+        size_t value = code.find(" = ", fn) + 3;
+        textEdit e{ value, 1, "7 * y" };
+        string edited = applyEdit(code, e);
+
+        Interner names;
+        Diagnostics diags;
+        vector<token> toks = tokenize(code, names);
+        Parser incremental(toks, names);
+        incremental.parse(diags);
+        tokenChange change = relex(toks, code, edited, e, names);
+        ASTNode* updated = nullptr;
+        double tReparse = bestOf(1, [&] { updated = incremental.reparse(toks, change, diags); });
+
+        Parser fresh(toks, names);
+        ASTNode* rebuilt = nullptr;
+        double tParse = bestOf(1, [&] { rebuilt = fresh.parse(diags); });
+
+        ostringstream a, b;
+        incremental.print(a);
+        fresh.print(b);
+        printf("%27.0f%% %12.3f %12.3f %12s\n", at * 100, tReparse * 1e3, tParse * 1e3,
+               a.str() == b.str() && updated->childCount == rebuilt->childCount ? "yes" : "NO");
+    }
+}
+
+// Heap allocations per token for Parser::parse() and SemanticAnalyzer::analyze(),
+// and for the reference parser on the reference lexer's tokens (constructor
+// included, since it copies them). Output goes to a stream with no buffer, so
+// printing costs (almost) nothing. parse() runs once: a Parser builds one tree.
+void benchParserAllocations(const string& code) {
+    vector<legacy::token> legacyToks = legacy::tokenize(code);
+    size_t before = allocationCount;
+    double tLegacy = bestOf(1, [&] {
+        legacy::Parser p(legacyToks);
+        p.parse();
+    });
+    size_t legacyAllocs = allocationCount - before;
+
+    Interner names;
+    Diagnostics diags;
+    vector<token> toks = tokenize(code, names);
+    ostream sink(nullptr);
+
+    before = allocationCount;
+    Parser p(toks, names);
+    ASTNode* root = nullptr;
+    double tParse = bestOf(1, [&] { root = p.parse(diags); });
+    size_t parseAllocs = allocationCount - before;
+
+    before = allocationCount;
+    double tSem = bestOf(1, [&] {
+        SemanticAnalyzer sem(names, diags);
+        sem.analyze(root, sink);
+    });
+    size_t semAllocs = allocationCount - before;
+
+    printf("== lookahead/allocation: %zu tokens (before = reference parser, after = Parser)\n", toks.size());
+    printf("%-28s %12s %12s %12s %12s\n", "", "before ms", "allocs/token", "after ms", "allocs/token");
+    printf("%-28s %12.3f %12.3f %12.3f %12.3f\n", "Parser::parse()", tLegacy * 1e3,
+           (double)legacyAllocs / legacyToks.size(), tParse * 1e3, (double)parseAllocs / toks.size());
+    printf("%-28s %12s %12s %12.3f %12.3f\n", "SemanticAnalyzer::analyze()", "", "", tSem * 1e3,
+           (double)semAllocs / toks.size());
+}
+
+// SemanticAnalyzer::analyze() checking function bodies on 1 … N threads
+// against the sequential walk; every run must print the same table.
+void benchParallelSemantic(const string& code) {
+    Interner names;
+    Diagnostics diags;
+    vector<token> toks = tokenize(code, names);
+    Parser p(toks, names);
+    ASTNode* root = p.parse(diags);
+    size_t functions = count_if(root->begin(), root->end(), [](ASTNode* n) { return n->kind == astFunction; });
+
+    auto analyze = [&](unsigned threads, string& table) {
+        ostringstream out;
+        double t = bestOf(3, [&] {
+            out.str("");
+            SemanticAnalyzer sem(names, diags, threads);
+            sem.analyze(root, out);
+        });
+        table = out.str();
+        return t;
+    };
+    string seqTable;
+    double tSeq = analyze(1, seqTable);
+
+    unsigned hw = max(1u, thread::hardware_concurrency());
+    printf("== parallel semantic analysis: %zu functions, %u hardware threads\n", functions, hw);
+    printf("%-28s %10s %10s\n", "threads", "ms", "speedup");
+    printf("%28s %10.3f %9.2fx\n", "sequential", tSeq * 1e3, 1.0);
+    for (unsigned threads = 2; threads <= max(8u, hw); threads *= 2) {
+        string table;
+        double t = analyze(threads, table);
+        printf("%28u %10.3f %9.2fx%s\n", threads, t * 1e3, tSeq / t, table == seqTable ? "" : "  OUTPUTS DIFFER");
+    }
+}
+
+// Nested blocks `depth` deep; every level declares one variable and reads
+// the global, the outermost local and its parent's variable.
+string makeNestedSource(int depth) {
+    string code = "int g = 1;\nint main() {\n";
+    for (int d = 0; d < depth; d++) {
+        string v = "v" + to_string(d);
+        string parent = d ? "v" + to_string(d - 1) : "g";
+        code += "{ int " + v + " = " + parent + "; " + v + " = g; " + v + " = v0;\n";
+    }
+    code += string(depth, '}') + "\n}\n";
+    return code;
+}
+
+// Same declare/lookup sequence against both scope layouts (string keys vs.
+// interned IDs), then the whole semantic pass over a deeply nested program.
+void benchSymbolTable(const vector<int>& depths) {
+    printf("== scoped symbol table: 4 lookups per level (global, outermost, parent, own)\n");
+    printf("%8s %16s %16s %16s\n", "depth", "map stack ns/op", "flat table ns/op", "analyze() ms");
+    for (int depth : depths) {
+        vector<string> names;
+        for (int d = 0; d < depth; d++) names.push_back("v" + to_string(d));
+        Interner interner;
+        Diagnostics diags;
+        uint32_t g = interner.intern("g");
+        vector<uint32_t> ids;
+        for (auto& n : names) ids.push_back(interner.intern(n));
+        long found = 0;
+
+        double tMaps = bestOf(3, [&] {
+            legacy::scopeStack st;
+            st.declare("g", 0);
+            for (int d = 0; d < depth; d++) {
+                st.pushScope();
+                st.declare(names[d], d + 1);
+                found += st.lookup("g") + st.lookup(names[0]) + st.lookup(names[d / 2]) + st.lookup(names[d]);
+            }
+            for (int d = 0; d < depth; d++) st.popScope();
+        });
+
+        double tFlat = bestOf(3, [&] {
+            ScopedSymbolTable st;
+            st.declare(g, 0);
+            for (int d = 0; d < depth; d++) {
+                st.pushScope();
+                st.declare(ids[d], d + 1);
+                found += st.lookup(g) + st.lookup(ids[0]) + st.lookup(ids[d / 2]) + st.lookup(ids[d]);
+            }
+            for (int d = 0; d < depth; d++) st.popScope();
+        });
+
+        string code = makeNestedSource(depth);
+        vector<token> toks = tokenize(code, interner);
+        Parser p(toks, interner);
+        ASTNode* root = p.parse(diags);
+        ostream sink(nullptr);
+        double tSem = bestOf(3, [&] {
+            SemanticAnalyzer sem(interner, diags);
+            sem.analyze(root, sink);
+        });
+
+        double ops = 5.0 * depth;  // one declare + four lookups per level
+        printf("%8d %16.1f %16.1f %16.3f\n", depth, tMaps / ops * 1e9, tFlat / ops * 1e9, tSem * 1e3);
+        benchSink = found;
+    }
+}
+
+// Runs fn() on a thread whose stack is painted beforehand; returns how many
+// bytes of that stack were touched (thread start-up included).
+template <class F>
+size_t stackHighWater(F&& fn) {
+    const size_t size = 16 << 20;
+    const unsigned char paint = 0xA5;
+    char* stack = (char*)aligned_alloc(4096, size);
+    memset(stack, paint, size);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, size);
+    pthread_t t;
+    pthread_create(&t, &attr, [](void* f) -> void* { (*(F*)f)(); return nullptr; }, (void*)&fn);
+    pthread_join(t, nullptr);
+    pthread_attr_destroy(&attr);
+    size_t untouched = 0;  // the stack grows down from the end
+    while (untouched < size && (unsigned char)stack[untouched] == paint) untouched++;
+    free(stack);
+    return size - untouched;
+}
+
+// One program nesting `shape` `depth` levels deep.
+string makeDeepSource(const string& shape, int depth) {
+    string code = "int main() {\nint x = 1;\n";
+    if (shape == "blocks")
+        code += string(depth, '{') + "x = 2;" + string(depth, '}');
+    else if (shape == "ifs")
+        for (int d = 0; d <= depth; d++) code += d < depth ? "if (x < 2) " : "x = 2;";
+    else if (shape == "parens")
+        code += "x = " + string(depth, '(') + "x" + string(depth, ')') + ";";
+    else  // "operators": a left-leaning tree of + nodes
+        for (int d = 0; d <= depth; d++) code += d ? " + x" : "x = x";
+    return code + (shape == "operators" ? ";\n}\n" : "\n}\n");
+}
+
+// Parsing, the semantic checks and printing the tree of inputs nested 10 to
+// 100k levels deep. They keep their own stacks, so time per level stays flat
+// and the native stack they use does not grow with depth. The tree is
+// printed as JSON: the text tree indents every line by its depth, so its
+// size, unlike the walk, grows with depth squared.
+void benchNestingDepth(const vector<int>& depths) {
+    printf("== nesting depth: time per level and native stack used (parse + check + print)\n");
+    printf("%-10s %8s %9s %9s %9s %10s %9s\n", "shape", "depth", "parse ms", "check ms", "print ms",
+           "ns/level", "stack KB");
+    for (const char* shape : { "blocks", "ifs", "parens", "operators" }) {
+        for (int depth : depths) {
+            string code = makeDeepSource(shape, depth);
+            Interner names;
+            vector<token> toks = tokenize(code, names);
+            ASTNode* root = nullptr;
+            unique_ptr<Parser> parser;
+            bool clean = true;
+            double tParse = bestOf(3, [&] {
+                parser = make_unique<Parser>(toks, names);
+                Diagnostics d(0);
+                root = parser->parse(d);
+                clean = d.empty();
+            });
+            double tCheck = bestOf(3, [&] {
+                Diagnostics d(0);
+                SemanticAnalyzer sem(names, d);
+                clean = sem.check(root) && clean;
+            });
+            OutputBuffer buf(toks.size() * 64);
+            auto print = [&] {
+                buf.clear();
+                StructuredOutput doc(buf, formatJson);
+                doc.tree(root);
+                doc.finish();
+            };
+            double tPrint = bestOf(3, print);
+
+            size_t stack = stackHighWater([&] {
+                Parser p(toks, names);
+                Diagnostics d(0);
+                ASTNode* r = p.parse(d);
+                SemanticAnalyzer sem(names, d);
+                sem.check(r);
+                root = r;
+                print();
+            });
+            double total = tParse + tCheck + tPrint;
+            printf("%-10s %8d %9.3f %9.3f %9.3f %10.1f %9.1f%s\n", shape, depth, tParse * 1e3, tCheck * 1e3,
+                   tPrint * 1e3, total / depth * 1e9, stack / 1024.0, clean ? "" : "  INPUT HAS ERRORS");
+        }
+    }
+}
+
+// One assignment whose right side is `operands` operands joined by the
+// operators of `shape`: "additive" (+ and -), "mixed" (every binary
+// operator, in a fixed pseudo-random order), "ascending" (each operator
+// binding tighter than the one before, so they pile up on the stack) and
+// "descending" (each binding looser, so every one applies at once).
+string makeFlatExpression(const string& shape, int operands) {
+    static const char* const loosestFirst[] = { "|", "^", "&", "<<", "+", "*" };
+    static const char* const all[] = { "+", "-", "*", "/", "%", "<<", ">>", "&", "^", "|" };
+    string code = "int main() {\nint x = 1;\nx = x";
+    uint32_t state = 1;
+    for (int i = 1; i < operands; i++) {
+        const char* op;
+        if (shape == "additive")
+            op = i % 2 ? "+" : "-";
+        else if (shape == "mixed")
+            op = all[((state = state * 1103515245 + 12345) >> 16 & 0x7fff) % 10];
+        else if (shape == "ascending")
+            op = loosestFirst[(i - 1) % 6];
+        else
+            op = loosestFirst[5 - (i - 1) % 6];
+        code += " ";
+        code += op;
+        code += i % 3 ? " x" : " 1";
+    }
+    return code + ";\n}\n";
+}
+
+// True if the trees under a and b are the same node for node.
+bool sameTree(const ASTNode* a, const ASTNode* b) {
+    vector<pair<const ASTNode*, const ASTNode*>> todo{ { a, b } };
+    while (!todo.empty()) {
+        auto [x, y] = todo.back();
+        todo.pop_back();
+        if (!x || !y) {
+            if (x != y) return false;
+            continue;
+        }
+        if (x->kind != y->kind || x->childCount != y->childCount || x->sym != y->sym ||
+            x->value != y->value || x->line != y->line || x->col != y->col)
+            return false;
+        for (unsigned k = 0; k < x->childCount; k++)
+            todo.push_back({ x->children[k], y->children[k] });
+    }
+    return true;
+}
+
+// Long flat expressions through Parser::parse() (one table lookup per
+// operator) and through the reference cascade (one call for every tier below
+// each operator, and more as the tiers alternate): time, the cascade's tier
+// functions entered and, where the CPU counters can be read, branches
+// mispredicted, all per operand.
+void benchFlatExpressions(int operands) {
+    perfCounter misses(PERF_COUNT_HW_BRANCH_MISSES);
+    printf("== flat expressions: %d operands, per operand (engine = operator table, cascade = reference)%s\n",
+           operands, misses.ok() ? "" : "; branch counters unavailable");
+    printf("%-11s %10s %10s %10s %10s %10s\n", "shape", "engine ns", "cascade ns", "cascade fn",
+           "engine bm", "cascade bm");
+    for (const char* shape : { "additive", "mixed", "ascending", "descending" }) {
+        string code = makeFlatExpression(shape, operands);
+        Interner names;
+        vector<token> toks = tokenize(code, names);
+        int begin = 0;  // the right side of the assignment: after the second '='
+        for (int seen = 0; seen < 2; begin++)
+            seen += toks[begin].id == opAssign;
+
+        unique_ptr<Parser> parser;
+        ASTNode* root = nullptr;
+        long engineMisses = LONG_MAX, cascadeMisses = LONG_MAX, cascadeCalls = 0;
+        double tEngine = bestOf(5, [&] {
+            engineMisses = min(engineMisses, misses.count([&] {
+                parser = make_unique<Parser>(toks, names);
+                Diagnostics d(0);
+                root = parser->parse(d);
+            }));
+        });
+        unique_ptr<Arena> arena;  // the last run's, which holds `reference`
+        ASTNode* reference = nullptr;
+        double tCascade = bestOf(5, [&] {
+            arena = make_unique<Arena>();
+            legacy::cascadeParser cascade{ toks, names, *arena, begin };
+            cascadeMisses = min(cascadeMisses, misses.count([&] { reference = cascade.tier(1); }));
+            cascadeCalls = cascade.calls;
+        });
+        // program → function → block → the assignment's right side
+        const ASTNode* assignment = root->children[0]->children[2]->children[1];
+        bool same = sameTree(assignment->children[1], reference);
+        auto perOperand = [&](long n) { return misses.ok() ? to_string(n / (double)operands).substr(0, 6) : "n/a"; };
+        printf("%-11s %10.1f %10.1f %10.3f %10s %10s%s\n", shape, tEngine / operands * 1e9,
+               tCascade / operands * 1e9, cascadeCalls / (double)operands,
+               perOperand(engineMisses).c_str(), perOperand(cascadeMisses).c_str(),
+               same ? "" : "  TREES DIFFER");
+    }
+}
+
+// Each corpus shape through tokenize(), Parser::parse() and the semantic
+// checks (SemanticAnalyzer::check(), i.e. analyze() without printing the
+// table), timed separately.
+void benchCorpusSuite(size_t bytes) {
+    printf("== corpus suite: ~%zu bytes per shape, phases timed separately (MB/s of source)\n", bytes);
+    printf("   (tests/stmt: table lookups and token comparisons made to pick each statement's production)\n");
+    printf("%-16s %9s %9s %9s %9s %9s %9s %10s %10s\n", "shape", "tokens", "nodes", "stmts",
+           "lex ms", "parse ms", "sem ms", "tests/stmt", "total MB/s");
+    for (const corpusShape& shape : corpusShapes) {
+        string code = makeCorpus(shape, bytes);
+
+        Interner names;
+        vector<token> toks;
+        double tLex = bestOf(5, [&] {
+            Interner fresh;
+            toks = tokenize(code, fresh);
+        });
+        toks = tokenize(code, names);
+
+        Diagnostics diags(0);
+        ASTNode* root = nullptr;
+        unique_ptr<Parser> parser;
+        double tParse = bestOf(5, [&] {
+            parser = make_unique<Parser>(toks, names);
+            Diagnostics d(0);
+            root = parser->parse(d);
+        });
+        parser = make_unique<Parser>(toks, names);
+        root = parser->parse(diags);
+        const statementCounts& counts = parser->dispatchCounts();
+        size_t nodes = 0;
+        vector<const ASTNode*> stack{ root };
+        while (!stack.empty()) {
+            const ASTNode* n = stack.back();
+            stack.pop_back();
+            nodes++;
+            for (const ASTNode* child : *n)
+                if (child) stack.push_back(child);
+        }
+
+        double tSem = bestOf(5, [&] {
+            Diagnostics d(0);
+            SemanticAnalyzer sem(names, d);
+            benchSink = sem.check(root);
+        });
+        SemanticAnalyzer sem(names, diags);
+        sem.check(root);
+
+        double total = tLex + tParse + tSem;
+        double statements = max(counts.statements, 1L);
+        printf("%-16s %9zu %9zu %9ld %9.3f %9.3f %9.3f %10.3f %10.1f%s\n", shape.name, toks.size(),
+               nodes, counts.statements, tLex * 1e3, tParse * 1e3, tSem * 1e3,
+               counts.selectionTests / statements, code.size() / total / 1e6,
+               diags.empty() ? "" : "  CORPUS HAS ERRORS");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    countAllocations = true;  // benchmarks report allocationCount differences
+    string first = argc > 1 ? argv[1] : "";
+    if (first == "--corpus") {
+        const corpusShape* shape = argc > 2 ? findCorpusShape(argv[2]) : nullptr;
+        if (!shape) {
+            fprintf(stderr, "Usage: benchmark --corpus <shape> [size_mb] [unit_size]\nShapes:\n");
+            for (const corpusShape& s : corpusShapes)
+                fprintf(stderr, "  %-16s %s (unit size %d)\n", s.name, s.stresses, s.size);
+            return 1;
+        }
+        double sizeMb = argc > 3 ? atof(argv[3]) : 1.0;
+        int size = argc > 4 ? atoi(argv[4]) : 0;
+        string code = makeCorpus(*shape, (size_t)(sizeMb * 1e6), size);
+        fwrite(code.data(), 1, code.size(), stdout);
+        return 0;
+    }
+    if (first == "--expr") {
+        benchFlatExpressions(argc > 2 ? atoi(argv[2]) : 100000);
+        return 0;
+    }
+    if (first == "--depth") {
+        benchNestingDepth({10, 100, 1000, 10000, 100000});
+        return 0;
+    }
+    bool suiteOnly = first == "--suite";
+    double sizeMb = argc > 1 + suiteOnly ? atof(argv[1 + suiteOnly]) : 1.0;
+    if (suiteOnly) {
+        benchCorpusSuite((size_t)(sizeMb * 1e6));
+        return 0;
+    }
+
+    string code = makeSource((size_t)(sizeMb * 1e6));
+    benchLexer(code);
+    benchScanKernels(code.size());
+    benchParallelLexer(code);
+    benchIncrementalLex(code);
+    benchIncrementalParse(code);
+    benchParserAllocations(code);
+    benchParallelSemantic(code);
+    benchSymbolTable({10, 100, 1000, 5000});
+    benchNestingDepth({10, 100, 1000, 10000, 100000});
+    benchFlatExpressions(100000);
+    benchCorpusSuite(code.size());
+    return 0;
+}
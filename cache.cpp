@@ -0,0 +1,405 @@
+// cache.cpp
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <link.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "output.cpp"  // Includes semantic.cpp → syntax.cpp → lexical.cpp
+using namespace std;
+
+// ————————————————————————————— Phase Results —————————————————————————————
+// What the phases of one run produced, by pointer: a fresh run points into
+// its token vector, Parser and SemanticAnalyzer, a cached run into its
+// snapshot. `root` is set only if the source parsed without errors, and
+// `symbols` only if the semantic checks then passed; otherwise the run's
+// Diagnostics hold the errors of the phase that failed.
+struct phaseResults {
+    const vector<token>* toks = nullptr;
+    const ASTNode* root = nullptr;
+    const vector<pair<uint32_t, Symbol>>* symbols = nullptr;
+    const Interner* names = nullptr;  // resolves the symbols' name and type IDs
+    bool parsed = false;              // the syntax phase ran
+    bool checked = false;             // the semantic phase ran
+};
+
+// ————————————————————————————— Result Cache —————————————————————————————
+// Finished runs on local disk, one snapshot file per source text, so that a
+// resubmission, in any mode, is answered without lexing or parsing. A
+// snapshot holds every phase's results (tokens, tree, symbol table or the
+// errors of the phase that failed), which is what each mode's output is made
+// from. The key is a 128-bit hash of the source, the error limit and the
+// build (see analyzerBuild()), since a rebuilt analyzer may analyze
+// differently. The hash is not
+// collision resistant, so a snapshot also holds the source itself and is a
+// hit only if that matches byte for byte.
+//
+// Snapshot file: "PVS2", u32 flags (see below), u32 error limit, u64 source
+// size, the source bytes, then a binary-format document (output.cpp) with
+// the sections 'T', 'A' if parsed cleanly, 'S' if checked cleanly, and 'E'.
+//
+// Files are written under a temporary name and renamed into place, so
+// several processes can share a directory. A hit updates the file's mtime;
+// once the directory grows past its capacity the least recently used
+// snapshots are removed until it is back under 90% of it.
+enum snapshotFlag : uint32_t { snapParsed = 1, snapChecked = 2, snapTree = 4, snapSymbols = 8 };
+
+// Two independent 64-bit hashes of `s` in one pass, 8 bytes per step.
+pair<uint64_t, uint64_t> hashBytes(string_view s) {
+    const uint64_t k1 = 0x9E3779B97F4A7C15ull, k2 = 0xC2B2AE3D27D4EB4Full;
+    auto mix = [](uint64_t x) {
+        x ^= x >> 31;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 29;
+        return x;
+    };
+    uint64_t a = s.size() * k1, b = ~s.size() * k2;
+    size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) {
+        uint64_t w;
+        memcpy(&w, s.data() + i, 8);
+        a = (a ^ w) * k1;
+        a ^= a >> 32;
+        b = (b ^ w) * k2;
+        b ^= b >> 29;
+    }
+    uint64_t w = 0;
+    memcpy(&w, s.data() + i, s.size() - i);
+    a = mix((a ^ w) * k1);
+    b = mix((b ^ w) * k2);
+    return { a, b };
+}
+
+// Identifies the code that analyzes: a hash of the read-only segments (code
+// and constants) of the binary this is linked into, the analyzer or the
+// library, as loaded. Every phase is compiled into it, so a change to any of
+// them that can change a result changes the ID, whatever was recompiled.
+// (The fallback below, for when the segments cannot be found, is the compile
+// time, which is among the constants hashed: every build gets its own ID.)
+const string& analyzerBuild() {
+    static const string id = [] {
+        struct search {
+            uintptr_t self;
+            string hashes;  // one per segment
+        } s{ (uintptr_t)&analyzerBuild, {} };
+        dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+            search& s = *(search*)data;
+            auto segments = [&](auto fn) {
+                for (int k = 0; k < info->dlpi_phnum; k++)
+                    if (info->dlpi_phdr[k].p_type == PT_LOAD)
+                        fn(info->dlpi_phdr[k], info->dlpi_addr + info->dlpi_phdr[k].p_vaddr);
+            };
+            bool mine = false;
+            segments([&](const ElfW(Phdr)& ph, uintptr_t at) { mine |= s.self >= at && s.self < at + ph.p_memsz; });
+            if (!mine)
+                return 0;
+            segments([&](const ElfW(Phdr)& ph, uintptr_t at) {
+                if (ph.p_flags & PF_W) return;  // relocated or written at run time
+                auto [a, b] = hashBytes(string_view((const char*)at, ph.p_filesz));
+                s.hashes.append((const char*)&a, 8).append((const char*)&b, 8);
+            });
+            return 1;
+        }, &s);
+        if (s.hashes.empty())
+            return string(__DATE__ " " __TIME__);
+        auto [a, b] = hashBytes(s.hashes);
+        char hex[33];
+        snprintf(hex, sizeof(hex), "%016llx%016llx", (unsigned long long)a, (unsigned long long)b);
+        return string(hex);
+    }();
+    return id;
+}
+
+// A snapshot read back: mapped read-only, with the tokens, tree and symbol
+// table rebuilt over it. Token and node text point into the mapping.
+class cachedRun {
+    const char* map = nullptr;
+    size_t mapSize = 0;
+    vector<token> toks;
+    Arena nodes;
+    Interner names;
+    vector<pair<uint32_t, Symbol>> symbols;
+
+public:
+    phaseResults results;
+    Diagnostics diags;
+
+    cachedRun() = default;
+    cachedRun(const cachedRun&) = delete;
+    cachedRun& operator=(const cachedRun&) = delete;
+    ~cachedRun() {
+        if (map) munmap((void*)map, mapSize);
+    }
+
+    // Maps and decodes `path`; false if it is missing or not a snapshot of
+    // `source`.
+    bool load(const string& path, string_view source) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                map = (const char*)p;
+                mapSize = st.st_size;
+            }
+        }
+        close(fd);
+        return map && decode(source);
+    }
+
+private:
+    // Bounds-checked reads over the mapping; `ok` drops to false on overrun.
+    struct reader {
+        const char* p;
+        const char* end;
+        bool ok = true;
+
+        bool need(size_t n) { return ok = ok && (size_t)(end - p) >= n; }
+        unsigned u8() { return need(1) ? (unsigned char)*p++ : 0; }
+        uint32_t u32() {
+            if (!need(4)) return 0;
+            uint32_t v = 0;
+            for (int k = 0; k < 4; k++) v |= (uint32_t)(unsigned char)p[k] << (8 * k);
+            p += 4;
+            return v;
+        }
+        int i32() { return (int)u32(); }
+        uint64_t u64() {
+            uint64_t lo = u32();
+            return lo | (uint64_t)u32() << 32;
+        }
+        string_view bytes() {
+            uint32_t n = u32();
+            if (!need(n)) return {};
+            string_view s(p, n);
+            p += n;
+            return s;
+        }
+    };
+
+    bool decode(string_view source) {
+        reader in{ map, map + mapSize };
+        if (!in.need(8) || memcmp(in.p, "PVS2", 4) != 0)
+            return false;
+        in.p += 4;
+        uint32_t flags = in.u32();
+        diags = Diagnostics(in.u32());  // the limit is part of the key
+        if (in.u64() != source.size() || !in.need(source.size()) || memcmp(in.p, source.data(), source.size()) != 0)
+            return false;  // another source with the same key
+        in.p += source.size();
+        if (!in.need(4) || memcmp(in.p, "PVA1", 4) != 0)
+            return false;
+        in.p += 4;
+
+        for (unsigned tag; in.ok && (tag = in.u8()) != 0;) {
+            uint32_t count = in.u32();
+            if (count > mapSize)  // every record takes at least a byte
+                return false;
+            if (tag == 'T') {
+                toks.reserve(count);
+                for (uint32_t k = 0; k < count && in.ok; k++) {
+                    unsigned type = in.u8();
+                    if (type > unknown) return false;
+                    int line = in.i32(), col = in.i32();
+                    toks.push_back({ (tokenType)type, Interner::none, in.bytes(), line, col });
+                }
+            } else if (tag == 'A') {
+                results.root = readTree(in, count);
+            } else if (tag == 'S') {
+                symbols.reserve(count);
+                for (uint32_t k = 0; k < count && in.ok; k++) {
+                    uint32_t name = names.intern(in.bytes());
+                    uint32_t type = names.intern(in.bytes());
+                    int scope = in.i32();
+                    unsigned address = in.u32();
+                    symbols.push_back({ name, Symbol{ type, scope, address, string(in.bytes()) } });
+                }
+            } else if (tag == 'E') {
+                vector<string_view> messages;
+                for (uint32_t k = 0; k < count && in.ok; k++)
+                    messages.push_back(in.bytes());
+                in.u8();  // limit reached: implied by the count and the limit
+                try {
+                    for (string_view m : messages)
+                        diags.report(string(m));
+                } catch (const ErrorLimitReached&) {
+                }
+            } else {
+                return false;
+            }
+        }
+        if (!in.ok || (bool)(flags & snapTree) != (results.root != nullptr))
+            return false;
+
+        results.toks = &toks;
+        results.names = &names;
+        results.parsed = flags & snapParsed;
+        results.checked = flags & snapChecked;
+        if (flags & snapSymbols)
+            results.symbols = &symbols;
+        return true;
+    }
+
+    // Rebuilds `count` preorder node records; null if they do not form one tree.
+    const ASTNode* readTree(reader& in, uint32_t count) {
+        struct open { ASTNode* node; unsigned filled; };
+        vector<open> stack;
+        ASTNode* root = nullptr;
+        for (uint32_t k = 0; k < count && in.ok; k++) {
+            unsigned kind = in.u8();
+            unsigned children = in.u32();
+            int line = in.i32(), col = in.i32();
+            string_view value = in.bytes();
+            if (kind > astString || children > count - k - 1)
+                return nullptr;
+            ASTNode** arr = children ? (ASTNode**)nodes.allocate(children * sizeof(ASTNode*), alignof(ASTNode*)) : nullptr;
+            ASTNode* n = nodes.make<ASTNode>((nodeKind)kind, children, line, col, Interner::none, arr, value);
+            if (stack.empty()) {
+                if (root) return nullptr;
+                root = n;
+            } else {
+                stack.back().node->children[stack.back().filled++] = n;
+            }
+            if (children)
+                stack.push_back({ n, 0 });
+            while (!stack.empty() && stack.back().filled == stack.back().node->childCount)
+                stack.pop_back();
+        }
+        return stack.empty() ? root : nullptr;
+    }
+};
+
+// Safe to share between the threads of one process (batch mode).
+class ResultCache {
+    string dir;
+    size_t capacity;
+    atomic<size_t> approxBytes{ 0 };  // directory size when last scanned, plus stores since
+    atomic<size_t> hits{ 0 }, misses{ 0 }, stores{ 0 }, evictions{ 0 };
+    atomic<unsigned> tempSeq{ 0 };
+    mutex evicting;
+
+public:
+    ResultCache(const string& directory, size_t capacityBytes) : dir(directory), capacity(capacityBytes) {
+        error_code ec;
+        filesystem::create_directories(dir, ec);
+        approxBytes = scan().second;
+    }
+
+    // Hex key of `code` analyzed with an error limit of `maxErrors`.
+    string keyFor(string_view code, size_t maxErrors) const {
+        auto [a, b] = hashBytes(code);
+        auto [c, d] = hashBytes(analyzerBuild() + "/" + to_string(maxErrors));
+        char key[33];
+        snprintf(key, sizeof(key), "%016llx%016llx", (unsigned long long)(a ^ c), (unsigned long long)(b ^ d));
+        return key;
+    }
+
+    // The snapshot of `source` stored under `key`, or null (a miss).
+    unique_ptr<cachedRun> find(const string& key, string_view source) {
+        string path = pathOf(key);
+        auto run = make_unique<cachedRun>();
+        if (!run->load(path, source)) {
+            misses++;
+            return nullptr;
+        }
+        utimensat(AT_FDCWD, path.c_str(), nullptr, 0);  // most recently used
+        hits++;
+        return run;
+    }
+
+    void store(const string& key, string_view source, const phaseResults& r, const Diagnostics& diags) {
+        OutputBuffer buf(source.size() + r.toks->size() * 24 + 4096);
+        buf.put("PVS2");
+        uint32_t flags = 0;
+        if (r.parsed) flags |= snapParsed;
+        if (r.checked) flags |= snapChecked;
+        if (r.root) flags |= snapTree;
+        if (r.symbols) flags |= snapSymbols;
+        buf.putU32(flags);
+        buf.putU32((uint32_t)diags.maxErrors());
+        buf.putU32((uint32_t)source.size());
+        buf.putU32((uint32_t)((uint64_t)source.size() >> 32));
+        buf.put(source);
+        StructuredOutput doc(buf, formatBinary);
+        doc.tokens(*r.toks);
+        if (r.root) doc.tree(r.root);
+        if (r.symbols) doc.symbols(*r.symbols, *r.names);
+        doc.errors(diags.all(), diags.limitReached());
+        doc.finish();
+
+        string path = pathOf(key);
+        string temp = path + ".tmp" + to_string(getpid()) + "." + to_string(tempSeq++);
+        {
+            ofstream out(temp, ios::binary);
+            buf.writeTo(out);
+            if (!out) {
+                remove(temp.c_str());
+                return;
+            }
+        }
+        if (rename(temp.c_str(), path.c_str()) != 0) {
+            remove(temp.c_str());
+            return;
+        }
+        stores++;
+        approxBytes += buf.size();
+        if (approxBytes > capacity)
+            evict();
+    }
+
+    // "hits H misses M stores S evictions E entries N bytes B"
+    string stats() {
+        auto [entries, bytes] = scan();
+        ostringstream s;
+        s << "hits " << hits << " misses " << misses << " stores " << stores << " evictions " << evictions
+          << " entries " << entries << " bytes " << bytes << "\n";
+        return s.str();
+    }
+
+    size_t hitCount() const { return hits; }
+    size_t missCount() const { return misses; }
+
+private:
+    string pathOf(const string& key) const { return dir + "/" + key + ".snap"; }
+
+    // (snapshot count, total bytes) of the directory.
+    pair<size_t, size_t> scan() const {
+        size_t entries = 0, bytes = 0;
+        error_code ec;
+        for (auto& e : filesystem::directory_iterator(dir, ec)) {
+            if (e.path().extension() != ".snap") continue;
+            entries++;
+            bytes += e.file_size(ec);
+        }
+        return { entries, bytes };
+    }
+
+    void evict() {
+        lock_guard<mutex> guard(evicting);
+        struct entry {
+            filesystem::file_time_type used;
+            size_t size;
+            filesystem::path path;
+        };
+        vector<entry> all;
+        size_t total = 0;
+        error_code ec;
+        for (auto& e : filesystem::directory_iterator(dir, ec)) {
+            if (e.path().extension() != ".snap") continue;
+            entry x{ e.last_write_time(ec), (size_t)e.file_size(ec), e.path() };
+            total += x.size;
+            all.push_back(move(x));
+        }
+        sort(all.begin(), all.end(), [](const entry& a, const entry& b) { return a.used < b.used; });
+        for (const entry& e : all) {
+            if (total <= capacity / 10 * 9) break;
+            if (filesystem::remove(e.path, ec)) {
+                total -= e.size;
+                evictions++;
+            }
+        }
+        approxBytes = total;
+    }
+};
@@ -1,7 +1,10 @@
 #include<bits/stdc++.h>
+#ifdef __SSE2__
+#include<immintrin.h>
+#endif
 using namespace std;
 
-enum tokenType {
+enum tokenType : unsigned char {
     keyword,    //0
     identifier, //1
     number,     //2
@@ -12,159 +15,848 @@ enum tokenType {
     unknown     //7
 };
 
+// ————————————————————————————— Fixed Symbols —————————————————————————————
+// Every keyword, operator and separator spelling has a fixed symbol ID, so the
+// later phases compare integers instead of strings. Keywords come first and
+// their IDs double as keyword IDs. "long long" can never come out of the word
+// scanner (words stop at spaces) but is kept for completeness; "std" is an
+// ordinary identifier that the parser looks for by ID.
+enum fixedSymbol : uint32_t {
+    kwInt, kwFloat, kwDouble, kwLongLong, kwChar, kwBool, kwString, kwIf, kwElse, kwFor,
+    kwWhile, kwTrue, kwFalse, kwReturn, kwVoid, kwBreak, kwContinue, kwSwitch, kwCase,
+    kwDefault, kwCout, kwCin, kwUsing, kwNamespace,
+    opPlus, opMinus, opStar, opSlash, opAssign, opPercent, opAmp, opPipe, opLess, opGreater,
+    opNot, opCaret, opShl, opShr, opLessEq, opGreaterEq, opEq, opNotEq,
+    sepLBrace, sepRBrace, sepComma, sepLBracket, sepRBracket, sepLParen, sepRParen, sepColon,
+    sepSemicolon,
+    idStd,
+    fixedSymbolCount
+};
+
+constexpr string_view fixedSpellings[fixedSymbolCount] = {
+    "int","float","double","long long","char","bool","string","if","else","for",
+    "while","true","false","return","void","break","continue","switch","case",
+    "default","cout","cin","using","namespace",
+    "+","-","*","/","=","%","&","|","<",">",
+    "!","^","<<",">>","<=",">=","==","!=",
+    "{","}",",","[","]","(",")",":",
+    ";",
+    "std"
+};
+
+constexpr int keywordCount = kwNamespace + 1;
+
+// ————————————————————————————— Arena —————————————————————————————
+// Bump allocator owned by a parse session. Nodes, child arrays and node text
+// are carved out of blocks that double in size and are released together when
+// the arena goes away, so building a tree never calls malloc per node and
+// freeing it costs one delete per block (O(log n)) rather than one per node.
+class Arena {
+    vector<unique_ptr<char[]>> blocks;
+    char* cur = nullptr;
+    size_t left = 0;
+    size_t nextBlock = 64 * 1024;
+    size_t handedOut = 0;
+
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t n, size_t align) {
+        size_t pad = (align - (uintptr_t)cur % align) % align;
+        if (pad + n > left) {
+            size_t sz = max(nextBlock, n + align);
+            blocks.emplace_back(new char[sz]);
+            cur = blocks.back().get();
+            left = sz;
+            nextBlock *= 2;
+            pad = (align - (uintptr_t)cur % align) % align;
+        }
+        char* p = cur + pad;
+        cur += pad + n;
+        left -= pad + n;
+        handedOut += pad + n;
+        return p;
+    }
+
+    // Bytes allocated so far, alignment padding included.
+    size_t used() const { return handedOut; }
+
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+    }
+
+    string_view copy(string_view s) {
+        if (s.empty()) return {};
+        char* p = (char*)allocate(s.size(), 1);
+        memcpy(p, s.data(), s.size());
+        return string_view(p, s.size());
+    }
+};
+
+// ————————————————————————————— Name Interning —————————————————————————————
+// One Interner is shared by every phase of an analysis run: tokenize() fills
+// it, and the parser, the semantic analyzer and the printers refer to names by
+// their dense 32-bit IDs, resolving text only for output. The fixed symbols are
+// interned first, so their IDs are the fixedSymbol values. Lookup is an
+// open-addressing (linear probing) hash table; the text is copied into an
+// Arena, so the views handed out stay valid as the table grows.
+class Interner {
+    Arena text;
+    vector<string_view> names;   // ID → text
+    vector<uint32_t> hashes;     // ID → hash, kept so growing never rehashes text
+    vector<uint32_t> slots;      // ID + 1, or 0 for an empty slot
+
+public:
+    static constexpr uint32_t none = UINT32_MAX;
+
+    Interner() : slots(256, 0) {
+        for (string_view s : fixedSpellings) intern(s);
+    }
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    // ID of `s`, or `none` if it has never been interned.
+    uint32_t find(string_view s) const {
+        uint32_t slot = slots[probe(s, hash(s))];
+        return slot ? slot - 1 : none;
+    }
+
+    uint32_t intern(string_view s) {
+        uint32_t h = hash(s);
+        size_t i = probe(s, h);
+        if (slots[i]) return slots[i] - 1;
+
+        uint32_t id = (uint32_t)names.size();
+        names.push_back(text.copy(s));
+        hashes.push_back(h);
+        slots[i] = id + 1;
+        if (names.size() * 2 > slots.size()) grow();
+        return id;
+    }
+
+    string_view name(uint32_t id) const { return names[id]; }
+    uint32_t size() const { return (uint32_t)names.size(); }
+
+private:
+    static uint32_t hash(string_view s) {
+        uint32_t h = 2166136261u;  // FNV-1a
+        for (unsigned char c : s) h = (h ^ c) * 16777619u;
+        return h;
+    }
+
+    size_t probe(string_view s, uint32_t h) const {
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i] && !(hashes[slots[i] - 1] == h && names[slots[i] - 1] == s))
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow() {
+        vector<uint32_t> old(slots.size() * 2, 0);
+        swap(slots, old);
+        size_t mask = slots.size() - 1;
+        for (uint32_t id = 0; id < names.size(); id++) {
+            size_t i = hashes[id] & mask;
+            while (slots[i]) i = (i + 1) & mask;
+            slots[i] = id + 1;
+        }
+    }
+};
+
+// A token is a view into the source buffer passed to tokenize(); it owns no
+// memory, so that buffer must outlive every token taken from it. `id` is the
+// interned symbol of keywords, identifiers, operators and separators, and
+// Interner::none for everything else.
 struct token {
     tokenType type;
-    string value;
+    uint32_t id;
+    string_view value;
     int line;
     int col;
 };
 
-unordered_set<string>keywords = {"int","float","double","long long","char","bool","string","if","else","for","while","true","false","return",
-                                "void","break","continue","switch","case","default","cout","cin","using","namespace"
+// ————————————————————————————— Character Classes —————————————————————————————
+// One table lookup per byte replaces the isspace()/isalnum() calls and the
+// operator/separator hash sets. Bytes >= 0x80 have no class (unknown).
+enum charClass : unsigned char {
+    CC_SPACE = 1,   // isspace() in the C locale
+    CC_ALPHA = 2,   // letters and '_' (may start an identifier)
+    CC_DIGIT = 4,
+    CC_DOT   = 8,   // '.' is part of a word so that "3.14" stays one token
+    CC_OP    = 16,  // + - * / = % & | < > ! ^
+    CC_SEP   = 32,  // { } , [ ] ( ) : ;
+    CC_WORD  = CC_ALPHA | CC_DIGIT | CC_DOT
+};
+
+struct charClassTable {
+    unsigned char cls[256] = {};
+    unsigned char sym[256] = {};  // fixed symbol of one-character operators/separators
+    constexpr charClassTable() {
+        for (char c : string_view(" \t\n\v\f\r")) cls[(unsigned char)c] = CC_SPACE;
+        for (int c = 'a'; c <= 'z'; c++) cls[c] = CC_ALPHA;
+        for (int c = 'A'; c <= 'Z'; c++) cls[c] = CC_ALPHA;
+        cls[(unsigned char)'_'] = CC_ALPHA;
+        for (int c = '0'; c <= '9'; c++) cls[c] = CC_DIGIT;
+        cls[(unsigned char)'.'] = CC_DOT;
+        for (char c : string_view("+-*/=%&|<>!^")) cls[(unsigned char)c] = CC_OP;
+        for (char c : string_view("{},[]():;")) cls[(unsigned char)c] = CC_SEP;
+        for (uint32_t s = opPlus; s <= sepSemicolon; s++)
+            if (fixedSpellings[s].size() == 1) sym[(unsigned char)fixedSpellings[s][0]] = s;
+    }
+    constexpr unsigned char operator[](char c) const { return cls[(unsigned char)c]; }
+    constexpr uint32_t symbol(char c) const { return sym[(unsigned char)c]; }
+};
+constexpr charClassTable charClasses;
+
+// ————————————————————————————— Keyword Recognizer —————————————————————————————
+// Perfect hash over (length, first char, last char), built at compile time: the
+// constructor searches for a multiplier that maps every keyword to its own slot.
+struct keywordHashTable {
+    static constexpr int size = 64;
+    signed char slot[size] = {};
+    unsigned mult = 0;
+
+    static constexpr unsigned hash(string_view w, unsigned m) {
+        return (w.size() * m + (unsigned char)w.front() * (m >> 4) + (unsigned char)w.back()) & (size - 1);
+    }
+
+    constexpr keywordHashTable() {
+        for (unsigned m = 1; m < 4096 && !mult; m++) {
+            for (auto& s : slot) s = -1;
+            bool ok = true;
+            for (int k = 0; k < keywordCount && ok; k++) {
+                unsigned h = hash(fixedSpellings[k], m);
+                if (slot[h] != -1) ok = false;
+                else slot[h] = k;
+            }
+            if (ok) mult = m;
+        }
+    }
+
+    // Keyword ID of `w`, or -1 if it is not a keyword.
+    constexpr int find(string_view w) const {
+        if (w.empty()) return -1;
+        int k = slot[hash(w, mult)];
+        return (k >= 0 && fixedSpellings[k] == w) ? k : -1;
+    }
 };
+constexpr keywordHashTable keywordTable;
+static_assert(keywordTable.mult != 0, "no perfect hash for the keyword list");
+
+// Same language as the old regex -?([0-9]+(\.[0-9]+)?|\.[0-9]+); the word
+// scanner never includes '-', so the sign is not handled here.
+bool isNumber(string_view str) {
+    size_t i = 0, n = str.size();
+    while (i < n && (charClasses[str[i]] & CC_DIGIT)) i++;
+    bool intPart = i > 0;
+    if (i < n && str[i] == '.') {
+        size_t fracStart = ++i;
+        while (i < n && (charClasses[str[i]] & CC_DIGIT)) i++;
+        return i == n && i > fracStart;
+    }
+    return intPart && i == n;
+}
 
-unordered_set<char>operators = {'+','-','*','/','=','%','&','|','<','>','!','^'};
+// Same language as the old regex [_a-zA-Z]+[_a-zA-Z0-9]*
+bool isIdentitfier(string_view str) {
+    if (str.empty() || !(charClasses[str[0]] & CC_ALPHA)) return false;
+    for (char c : str)
+        if (!(charClasses[c] & (CC_ALPHA | CC_DIGIT))) return false;
+    return true;
+}
 
-unordered_set<char>separators = {'{' , '}' , ',' , '[' , ']' , '(' , ')' , ':' , ';' };
+// ————————————————————————————— Scan Kernels —————————————————————————————
+// The byte loops the scanner spends its time in on comment-heavy code:
+// whitespace runs, comment bodies, string literals and the newlines inside
+// them. Each has a scalar version and SSE2/AVX2 versions that test 16/32
+// bytes per step; the widest one the CPU supports is picked at startup.
+// All of them look at bytes in [from, to) only and return `from` when the
+// range is empty.
+struct scanKernels {
+    const char* name;
+    size_t (*skipSpace)(const char* s, size_t from, size_t to);          // first non-space, or to
+    size_t (*findByte)(const char* s, size_t from, size_t to, char c);   // first c, or to
+    size_t (*findCommentEnd)(const char* s, size_t from, size_t to);     // first "*/", or max(from, to - 1)
+    size_t (*countNewlines)(const char* s, size_t from, size_t to);
+};
 
-bool isNumber(const string &str) {
-    return regex_match(str,regex("-?([0-9]+(\\.[0-9]+)?|\\.[0-9]+)"));
+namespace scalarScan {
+size_t skipSpace(const char* s, size_t from, size_t to) {
+    while (from < to && (charClasses[s[from]] & CC_SPACE)) from++;
+    return from;
+}
+size_t findByte(const char* s, size_t from, size_t to, char c) {
+    while (from < to && s[from] != c) from++;
+    return from;
+}
+size_t findCommentEnd(const char* s, size_t from, size_t to) {
+    while (from + 1 < to && !(s[from] == '*' && s[from + 1] == '/')) from++;
+    return from;
 }
+size_t countNewlines(const char* s, size_t from, size_t to) {
+    size_t n = 0;
+    for (; from < to; from++) n += s[from] == '\n';
+    return n;
+}
+} // namespace scalarScan
+
+const scanKernels scalarKernels{ "scalar", scalarScan::skipSpace, scalarScan::findByte,
+                                 scalarScan::findCommentEnd, scalarScan::countNewlines };
 
-bool isIdentitfier(const string& str) {
-    return regex_match(str,regex("[_a-zA-Z]+[_a-zA-Z0-9]*"));
+#ifdef __SSE2__
+namespace sse2Scan {
+// Whitespace is ' ' or '\t' … '\r'; the range test is one unsigned min.
+inline unsigned spaceMask(__m128i v) {
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8('\r' - '\t')), t);
+    return _mm_movemask_epi8(_mm_or_si128(ctrl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))));
 }
+size_t skipSpace(const char* s, size_t from, size_t to) {
+    for (; from + 16 <= to; from += 16) {
+        unsigned m = ~spaceMask(_mm_loadu_si128((const __m128i*)(s + from))) & 0xFFFF;
+        if (m) return from + __builtin_ctz(m);
+    }
+    return scalarScan::skipSpace(s, from, to);
+}
+size_t findByte(const char* s, size_t from, size_t to, char c) {
+    __m128i needle = _mm_set1_epi8(c);
+    for (; from + 16 <= to; from += 16) {
+        unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + from)), needle));
+        if (m) return from + __builtin_ctz(m);
+    }
+    return scalarScan::findByte(s, from, to, c);
+}
+size_t findCommentEnd(const char* s, size_t from, size_t to) {
+    __m128i star = _mm_set1_epi8('*'), slash = _mm_set1_epi8('/');
+    for (; from + 17 <= to; from += 16) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + from)), star);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + from + 1)), slash);
+        unsigned m = _mm_movemask_epi8(_mm_and_si128(a, b));
+        if (m) return from + __builtin_ctz(m);
+    }
+    return scalarScan::findCommentEnd(s, from, to);
+}
+size_t countNewlines(const char* s, size_t from, size_t to) {
+    __m128i nl = _mm_set1_epi8('\n');
+    size_t n = 0;
+    for (; from + 16 <= to; from += 16)
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + from)), nl)));
+    return n + scalarScan::countNewlines(s, from, to);
+}
+} // namespace sse2Scan
 
-vector<token> tokenize(const string &code) {
-    vector<token>tokens;
-    int i=0;
-    int len = code.length();
-    int line = 1;
-    int column = 1;
-    while(i < len) {
-        char c = code[i];
-
-        // Handle preprocessor directives like #include <...>
-        if (c == '#') {
-            int start = i;
-            while (i < len && code[i] != '\n') i++;
-            string val = code.substr(start, i - start-1);
-            tokens.push_back({tokenType::preprocessor, val, line, column});
-            column += (i - start);
-            continue;
+const scanKernels sse2Kernels{ "sse2", sse2Scan::skipSpace, sse2Scan::findByte,
+                               sse2Scan::findCommentEnd, sse2Scan::countNewlines };
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// Each kernel clears the upper halves of the ymm registers before its SSE2
+// tail: where GCC makes that call a jump it leaves out the vzeroupper it puts
+// before a return, and dirty upper halves make every SSE instruction the
+// process runs afterwards (memcpy, the parser's vector moves) pay for a state
+// transition.
+#define SCAN_AVX2 __attribute__((target("avx2")))
+namespace avx2Scan {
+SCAN_AVX2 inline unsigned spaceMask(__m256i v) {
+    __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8('\r' - '\t')), t);
+    return _mm256_movemask_epi8(_mm256_or_si256(ctrl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))));
+}
+SCAN_AVX2 size_t skipSpace(const char* s, size_t from, size_t to) {
+    for (; from + 32 <= to; from += 32) {
+        unsigned m = ~spaceMask(_mm256_loadu_si256((const __m256i*)(s + from)));
+        if (m) return from + __builtin_ctz(m);
+    }
+    _mm256_zeroupper();
+    return sse2Scan::skipSpace(s, from, to);
+}
+SCAN_AVX2 size_t findByte(const char* s, size_t from, size_t to, char c) {
+    __m256i needle = _mm256_set1_epi8(c);
+    for (; from + 32 <= to; from += 32) {
+        unsigned m = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + from)), needle));
+        if (m) return from + __builtin_ctz(m);
+    }
+    _mm256_zeroupper();
+    return sse2Scan::findByte(s, from, to, c);
+}
+SCAN_AVX2 size_t findCommentEnd(const char* s, size_t from, size_t to) {
+    __m256i star = _mm256_set1_epi8('*'), slash = _mm256_set1_epi8('/');
+    for (; from + 33 <= to; from += 32) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + from)), star);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + from + 1)), slash);
+        unsigned m = _mm256_movemask_epi8(_mm256_and_si256(a, b));
+        if (m) return from + __builtin_ctz(m);
+    }
+    _mm256_zeroupper();
+    return sse2Scan::findCommentEnd(s, from, to);
+}
+SCAN_AVX2 size_t countNewlines(const char* s, size_t from, size_t to) {
+    __m256i nl = _mm256_set1_epi8('\n');
+    size_t n = 0;
+    for (; from + 32 <= to; from += 32)
+        n += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + from)), nl)));
+    _mm256_zeroupper();
+    return n + sse2Scan::countNewlines(s, from, to);
+}
+} // namespace avx2Scan
+#undef SCAN_AVX2
+
+const scanKernels avx2Kernels{ "avx2", avx2Scan::skipSpace, avx2Scan::findByte,
+                               avx2Scan::findCommentEnd, avx2Scan::countNewlines };
+#endif
+
+const scanKernels* pickScanKernels() {
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return &avx2Kernels;
+#endif
+#ifdef __SSE2__
+    return &sse2Kernels;
+#else
+    return &scalarKernels;
+#endif
+}
+
+// The kernels every Lexer uses; the benchmark swaps in the others.
+const scanKernels* scan = pickScanKernels();
+
+// ————————————————————————————— Scanner —————————————————————————————
+// Hands out one token at a time. Between tokens the whole scanner state is
+// the position and the line/column counters, so a Lexer can be resumed at
+// the start of any token of an earlier scan with that token's line/col
+// (relex() relies on this). Words are interned into `names`, which must
+// outlive the tokens' IDs. With `stop`, no token is started at or after that
+// offset, though one that starts before it is scanned to its real end.
+class Lexer {
+    string_view code;
+    Interner& names;
+    int i;
+    int len;
+    int stop;
+    int line;
+    int column;
+
+    // Moves line/column over code[from, to), which the scanner skips.
+    void advance(int from, int to) {
+        size_t lines = scan->countNewlines(code.data(), from, to);
+        if (lines == 0) {
+            column += to - from;
+            return;
         }
+        int lineStart = to;
+        while (code[lineStart - 1] != '\n') lineStart--;
+        line += (int)lines;
+        column = 1 + (to - lineStart);
+    }
+
+public:
+    Lexer(string_view c, Interner& n, int pos = 0, int ln = 1, int col = 1, int stopAt = INT_MAX)
+        : code(c), names(n), i(pos), len((int)c.length()), stop(min(stopAt, len)), line(ln), column(col) {}
+
+    // Stores the next token in `t`; returns false at the end of the input.
+    bool next_token(token& t) {
+        while(i < stop) {
+            char c = code[i];
+            unsigned char cls = charClasses[c];
 
-        //Ignore spaces
-        if(isspace(c)) {
-            if(c == '\n') {
+            // Handle preprocessor directives like #include <...>
+            if (c == '#') {
+                int start = i;
+                i = (int)scan->findByte(code.data(), i, len, '\n');
+                t = {tokenType::preprocessor, Interner::none, code.substr(start, i - start-1), line, column};
+                column += (i - start);
+                return true;
+            }
+
+            //Ignore spaces
+            if(cls & CC_SPACE) {
+                int end = (int)scan->skipSpace(code.data(), i + 1, stop);
+                advance(i, end);
+                i = end;
+                continue;
+            }
+
+            //Ignore single line comments
+            if(c == '/' && i+1<len && code[i+1] =='/') {
+                i = (int)scan->findByte(code.data(), i + 2, len, '\n');
                 line++;
                 column = 1;
+                i++;
+                continue;
             }
-            else {
-                column++;
+
+            //Ignore multiline comments
+            if(c == '/' && i+1<len && code[i+1] == '*') {
+                i+=2;
+                column+=2;
+                int end = (int)scan->findCommentEnd(code.data(), i, len);
+                advance(i, end);
+                i = end + 2;
+                column+=2;
+                continue;
             }
-            i++;
-            continue;
-        }
 
-        //Ignore single line comments
-        if(c == '/' && i+1<len && code[i+1] =='/') {
-            i+=2;
-            while(i < len && code[i] != '\n')
+            //Identifing string literals
+            if(c == '"') {
                 i++;
-            line++;
-            column = 1;
-            i++;
-            continue;
-        }
+                int start = i;
+                i = (int)scan->findByte(code.data(), i, len, '"') + 1;
+                t = {tokenType::stringtype,Interner::none,code.substr(start,i-start-1),line,column};
+                column += (i-start);
+                return true;
+            }
+
+            //Identifying operators (including << and >>)
+            if (cls & CC_OP) {
+                int opLen = 1;
+                uint32_t sym = charClasses.symbol(c);
 
-        //Ignore multiline comments
-        if(c == '/' && i+1<len && code[i+1] == '*') {
-            i+=2;
-            column+=2;
-            while(i+1<len && !(code[i] == '*' && code[i+1] == '/')) {
-                if(code[i] == '\n') {
-                    line++;
-                    column = 1;
+                // Look ahead for <<, >>, <=, >=, ==, !=
+                if (i + 1 < len) {
+                    char next = code[i + 1];
+                    if (c == '<' && next == '<') sym = opShl;
+                    else if (c == '>' && next == '>') sym = opShr;
+                    else if (c == '<' && next == '=') sym = opLessEq;
+                    else if (c == '>' && next == '=') sym = opGreaterEq;
+                    else if (c == '=' && next == '=') sym = opEq;
+                    else if (c == '!' && next == '=') sym = opNotEq;
+                    if (sym >= opShl) opLen = 2;
                 }
-                else
-                    column++;
-                i++;
+
+                t = {tokenType::operaTor, sym, code.substr(i, opLen), line, column};
+                column += opLen;
+                i += opLen;
+                return true;
             }
-            i+=2;
-            column+=2;
-            continue;
-        } 
 
-        //Identifing string literals
-        if(c == '"') {
-            i++;
-            int start = i;
-            while(i < len && code[i] != '"') 
+            //Identifying separators
+            if(cls & CC_SEP) {
+                t = {tokenType::separator,charClasses.symbol(c),code.substr(i,1),line,column};
+                column++;
                 i++;
-            i++;
-            tokens.push_back({tokenType::stringtype,code.substr(start,i-start-1),line,column});
-            column += (i-start);
-            continue;
-        }
+                return true;
+            }
 
-        //Identifying operators (including << and >>)
-        if (operators.count(c)) {
-            string op(1, c);
-
-            // Look ahead for <<, >>, <=, >=, ==, !=
-            if (i + 1 < len) {
-                char next = code[i + 1];
-                if ((c == '<' && next == '<') || (c == '>' && next == '>') ||
-                    (c == '<' && next == '=') || (c == '>' && next == '=') ||
-                    (c == '=' && next == '=') || (c == '!' && next == '=')) {
-                    op += next;
+            //Identifying numbers,identifiers,keywords
+            if(cls & CC_WORD) {
+                int start = i;
+                while(i < len && (charClasses[code[i]] & CC_WORD))
                     i++;
+                string_view word = code.substr(start, i - start);
+                tokenType type;
+                uint32_t sym = Interner::none;
+                int kw = keywordTable.find(word);
+                if(kw >= 0) {
+                    type = tokenType::keyword;
+                    sym = kw;
+                }
+                else if(isNumber(word))
+                    type = tokenType::number;
+                else if(isIdentitfier(word)) {
+                    type = tokenType::identifier;
+                    sym = names.intern(word);
                 }
+                else
+                    type = tokenType::unknown;
+                t = {type,sym,word,line,column};
+                column += (i-start);
+                return true;
             }
 
-            tokens.push_back({tokenType::operaTor, op, line, column});
-            column += op.length();
+            //if anything else is found then unknown
+            t = {tokenType::unknown,Interner::none,code.substr(i,1),line,column};
             i++;
-            continue;
+            column++;
+            return true;
         }
 
-        //Identifying separators
-        if(separators.count(c)) {
-            tokens.push_back({tokenType::separator,string(1,c),line,column});
-            column++;
-            i++;
-            continue;
+        return false;
+    }
+
+    // Scanner state: where the next token would be looked for.
+    int offset() const { return i; }
+    int lineNo() const { return line; }
+    int columnNo() const { return column; }
+};
+
+vector<token> tokenize(string_view code, Interner& names) {
+    vector<token>tokens;
+    Lexer lexer(code, names);
+    token t;
+    while(lexer.next_token(t))
+        tokens.push_back(t);
+    return tokens;
+}
+
+// Byte offset of the first character of `t` within the code it was scanned
+// from; string values leave out their opening quote.
+size_t tokenStart(const token& t, string_view code) {
+    return (size_t)(t.value.data() - code.data()) - (t.type == stringtype);
+}
+
+// ————————————————————————————— Incremental Re-lexing —————————————————————————————
+// An edit replaces `removed` bytes at `offset` with `inserted`.
+struct textEdit {
+    size_t offset;
+    size_t removed;
+    string_view inserted;
+};
+
+string applyEdit(string_view code, const textEdit& e) {
+    string result;
+    result.reserve(code.size() - e.removed + e.inserted.size());
+    result.append(code.substr(0, e.offset));
+    result.append(e.inserted);
+    result.append(code.substr(e.offset + e.removed));
+    return result;
+}
+
+// What relex() did to the token vector: old tokens [begin, begin + removed)
+// were replaced by the new tokens [begin, begin + inserted). Every later token
+// moved down `lineShift` lines, and right `colShift` columns if it was on
+// line `syncLine` (old numbering), the line the two scans met on.
+struct tokenChange {
+    size_t begin;
+    size_t removed;
+    size_t inserted;
+    int lineShift;
+    int colShift;
+    int syncLine;
+};
+
+// Brings `toks`, the tokens of `oldCode`, up to date with `newCode`, which
+// is `oldCode` with `edit` applied, and reports which tokens changed.
+//
+// Scanning restarts at the last token that begins before the edit: a token
+// start is never inside a comment or string literal, and the scan up to it
+// only looked at bytes before the edit. (A plain line start would not do,
+// because newlines inside string literals do not advance the line counter,
+// so a line start does not tell which line number the scanner was at.)
+// Once the scanner reaches the start of an old token after the edit it is in
+// the same state as before, shifted by the size change, and the rest is
+// reused: lines move by the difference, columns too while still on the line
+// the two scans met on. Token text is rebased from oldCode onto newCode, so
+// oldCode only has to stay alive for the duration of the call.
+tokenChange relex(vector<token>& toks, string_view oldCode, string_view newCode,
+                  const textEdit& edit, Interner& names) {
+    ptrdiff_t delta = (ptrdiff_t)edit.inserted.size() - (ptrdiff_t)edit.removed;
+    size_t oldEditEnd = edit.offset + edit.removed;
+
+    // First token starting at or after the edit; the one before it is the restart point.
+    size_t first = partition_point(toks.begin(), toks.end(), [&](const token& t) {
+        return tokenStart(t, oldCode) < edit.offset;
+    }) - toks.begin();
+    size_t restart = first ? first - 1 : 0;
+    Lexer lexer = first
+        ? Lexer(newCode, names, (int)tokenStart(toks[restart], oldCode), toks[restart].line, toks[restart].col)
+        : Lexer(newCode, names);
+
+    // Old tokens from `resume` on start after the edit and are candidates for resynchronizing.
+    size_t resume = partition_point(toks.begin() + first, toks.end(), [&](const token& t) {
+        return tokenStart(t, oldCode) < oldEditEnd;
+    }) - toks.begin();
+
+    vector<token> fresh;
+    token t;
+    bool synced = false;
+    int dLine = 0, dCol = 0, syncLine = 0;
+    while (lexer.next_token(t)) {
+        size_t start = tokenStart(t, newCode);
+        while (resume < toks.size() && (ptrdiff_t)tokenStart(toks[resume], oldCode) + delta < (ptrdiff_t)start)
+            resume++;
+        if (resume < toks.size() && (ptrdiff_t)tokenStart(toks[resume], oldCode) + delta == (ptrdiff_t)start) {
+            synced = true;
+            syncLine = toks[resume].line;
+            dLine = t.line - toks[resume].line;
+            dCol = t.col - toks[resume].col;
+            break;
         }
+        fresh.push_back(t);
+    }
+    if (!synced)
+        resume = toks.size();
+    tokenChange change{ restart, resume - restart, fresh.size(), dLine, dCol, syncLine };
 
-        //Identifying numbers,identifiers,keywords
-        if(isalnum(c) || c == '_' || c == '.') {
-            int start = i;
-            while(i < len && (isalnum(code[i]) || code[i] =='_' || code[i] == '.'))
-                i++;
-            string val = code.substr(start,i-start);
-            tokenType type;
-            if(keywords.count(val))
-                type = tokenType::keyword;
-            else if(isNumber(val))
-                type = tokenType::number;
-            else if(isIdentitfier(val))
-                type = tokenType::identifier;
-            else
-                type = tokenType::unknown;
-            tokens.push_back({type,val,line,column});
-            column += (i-start);
-            continue;
+    // Rebase the untouched head, shift the reused tail, splice the rest in.
+    auto rebase = [&](token& u, ptrdiff_t shift) {
+        u.value = string_view(newCode.data() + (u.value.data() - oldCode.data()) + shift, u.value.size());
+    };
+    for (size_t k = 0; k < restart; k++)
+        rebase(toks[k], 0);
+    for (size_t k = resume; k < toks.size(); k++) {
+        rebase(toks[k], delta);
+        if (toks[k].line == syncLine)
+            toks[k].col += dCol;
+        toks[k].line += dLine;
+    }
+    toks.erase(toks.begin() + restart, toks.begin() + resume);
+    toks.insert(toks.begin() + restart, fresh.begin(), fresh.end());
+    return change;
+}
+
+// ————————————————————————————— Parallel Lexing —————————————————————————————
+// The input is cut into chunks at line starts and each chunk is lexed on its
+// own thread, speculatively: from column 1 outside any comment or string,
+// counting lines from 1, into a chunk-local Interner. A sequential fix-up pass
+// then takes the chunks in order. Where the previous chunk really ended at the
+// cut, the speculative tokens are right apart from their line numbers. Where
+// a block comment, string literal or directive ran over the cut, the chunk is
+// lexed again from where the previous one ended until it meets one of its own
+// token starts, as in relex(). Last, the chunks copy their tokens into place in
+// parallel, with local name IDs translated to `names` IDs that were handed out
+// in order of appearance, so the result is exactly what tokenize() returns.
+struct lexChunk {
+    int begin = 0, end = 0;       // [begin, end), begin at a line start
+    Interner local;
+    vector<token> toks;           // speculative tokens
+    int endPos = 0, endLine = 0, endCol = 0;  // scanner state after them
+
+    // Set by the fix-up pass:
+    vector<token> fixed;          // re-lexed tokens replacing toks[0, adopt)
+    size_t adopt = 0;
+    int lineShift = 0, colShift = 0, syncLine = 0;
+    vector<uint32_t> idMap;       // local ID → `names` ID
+    size_t outAt = 0;             // index of its first token in the result
+};
+
+// Runs fn(0) … fn(n - 1), one per thread (the caller's thread takes fn(0)).
+template <class F>
+void parallelFor(size_t n, F fn) {
+    vector<thread> workers;
+    for (size_t k = 1; k < n; k++)
+        workers.emplace_back(fn, k);
+    if (n) fn(0);
+    for (thread& w : workers)
+        w.join();
+}
+
+// Lexes `code` on up to `threads` threads; small inputs (under `minChunkBytes`
+// per thread) are not worth splitting and go through tokenize().
+vector<token> tokenizeParallel(string_view code, Interner& names, unsigned threads,
+                               size_t minChunkBytes = 1 << 16) {
+    size_t n = min<size_t>(threads, code.size() / max<size_t>(minChunkBytes, 1));
+    if (n <= 1)
+        return tokenize(code, names);
+
+    // Cut just after the first newline at or past each even split point.
+    vector<int> cuts{ 0 };
+    for (size_t k = 1; k < n; k++) {
+        size_t nl = code.find('\n', code.size() * k / n);
+        if (nl == string_view::npos) break;
+        if ((int)nl + 1 > cuts.back() && nl + 1 < code.size()) cuts.push_back((int)nl + 1);
+    }
+    cuts.push_back((int)code.size());
+    vector<lexChunk> chunks(cuts.size() - 1);
+
+    parallelFor(chunks.size(), [&](size_t k) {
+        lexChunk& c = chunks[k];
+        c.begin = cuts[k];
+        c.end = cuts[k + 1];
+        Lexer lexer(code, c.local, c.begin, 1, 1, c.end);
+        token t;
+        while (lexer.next_token(t))
+            c.toks.push_back(t);
+        c.endPos = lexer.offset();
+        c.endLine = lexer.lineNo();
+        c.endCol = lexer.columnNo();
+    });
+
+    // Fix-up, in order; (pos, line, col) is where the previous chunk really ended.
+    int pos = 0, line = 1, col = 1;
+    size_t total = 0;
+    for (lexChunk& c : chunks) {
+        bool synced = pos == c.begin;  // at the cut in the same state the chunk assumed
+        int syncLine = 1, syncCol = 1;
+        if (!synced) {
+            Lexer lexer(code, names, pos, line, col, c.end);
+            token t;
+            while (lexer.next_token(t)) {
+                size_t start = tokenStart(t, code);
+                while (c.adopt < c.toks.size() && tokenStart(c.toks[c.adopt], code) < start)
+                    c.adopt++;
+                if (c.adopt < c.toks.size() && tokenStart(c.toks[c.adopt], code) == start) {
+                    synced = true;
+                    syncLine = c.toks[c.adopt].line;
+                    syncCol = c.toks[c.adopt].col;
+                    line = t.line;
+                    col = t.col;
+                    break;
+                }
+                c.fixed.push_back(t);
+            }
+            if (!synced) {
+                c.adopt = c.toks.size();
+                pos = lexer.offset();
+                line = lexer.lineNo();
+                col = lexer.columnNo();
+            }
+        }
+        if (synced) {
+            c.lineShift = line - syncLine;
+            c.colShift = col - syncCol;
+            c.syncLine = syncLine;
+            pos = c.endPos;
+            col = c.endCol + (c.endLine == syncLine ? c.colShift : 0);
+            line = c.endLine + c.lineShift;
         }
 
-        //if anything else is found then unknown
-        tokens.push_back({tokenType::unknown,string(1,c),line,column});
-        i++;
-        column++;
-    } 
+        // Hand out `names` IDs for the adopted tokens in order of appearance;
+        // local IDs are already in that order when the whole chunk is adopted.
+        c.idMap.assign(c.local.size(), Interner::none);
+        for (uint32_t id = 0; id < fixedSymbolCount; id++)
+            c.idMap[id] = id;
+        if (c.adopt == 0) {
+            for (uint32_t id = fixedSymbolCount; id < c.local.size(); id++)
+                c.idMap[id] = names.intern(c.local.name(id));
+        } else {
+            for (size_t j = c.adopt; j < c.toks.size(); j++) {
+                uint32_t id = c.toks[j].id;
+                if (c.toks[j].type == identifier && c.idMap[id] == Interner::none)
+                    c.idMap[id] = names.intern(c.local.name(id));
+            }
+        }
+        c.outAt = total;
+        total += c.fixed.size() + (c.toks.size() - c.adopt);
+    }
+
+    vector<token> tokens(total);
+    parallelFor(chunks.size(), [&](size_t k) {
+        lexChunk& c = chunks[k];
+        token* out = tokens.data() + c.outAt;
+        out = copy(c.fixed.begin(), c.fixed.end(), out);
+        for (size_t j = c.adopt; j < c.toks.size(); j++) {
+            token t = c.toks[j];
+            if (t.line == c.syncLine)
+                t.col += c.colShift;
+            t.line += c.lineShift;
+            if (t.type == identifier)
+                t.id = c.idMap[t.id];
+            *out++ = t;
+        }
+    });
     return tokens;
 }
 
+// Non-owning view over a token vector. Parser and SemanticAnalyzer read the
+// tokens through it instead of each keeping a private copy; the vector must
+// outlive the view.
+struct tokenView {
+    const token* data = nullptr;
+    int count = 0;
+
+    tokenView(const vector<token>& t) : data(t.data()), count((int)t.size()) {}
+
+    int size() const { return count; }
+    const token& operator[](int i) const { return data[i]; }
+};
+
+// Returned by lookahead past the last token.
+const token endOfInput{ unknown, Interner::none, "", -1, -1 };
+
 string tokenToString(tokenType t) {
     switch(t) {
         case keyword:return "Keyword   ";
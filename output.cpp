@@ -0,0 +1,378 @@
+// output.cpp
+#include <bits/stdc++.h>
+#include "semantic.cpp"  // Includes syntax.cpp → lexical.cpp
+using namespace std;
+
+// ————————————————————————————— Output Formats —————————————————————————————
+// text:   the human-readable listing, tree and table (the default).
+// json:   one compact JSON document per run.
+// binary: the same content as length-prefixed little-endian records.
+enum outputFormat : unsigned char { formatText, formatJson, formatBinary };
+
+bool parseFormat(const string& name, outputFormat& f) {
+    if (name == "text") f = formatText;
+    else if (name == "json") f = formatJson;
+    else if (name == "binary") f = formatBinary;
+    else return false;
+    return true;
+}
+
+// ————————————————————————————— Output Buffer —————————————————————————————
+// Bytes are appended to one buffer sized up front from the input, so
+// formatting does no per-item stream calls or allocations, and the result is
+// handed to the stream in a single write. It still grows if the estimate
+// was short.
+class OutputBuffer {
+    unique_ptr<char[]> data;
+    size_t used = 0;
+    size_t capacity = 0;
+
+    void grow(size_t n) {
+        size_t cap = max(capacity * 2, used + n);
+        unique_ptr<char[]> bigger(new char[cap]);
+        if (used) memcpy(bigger.get(), data.get(), used);
+        data = move(bigger);
+        capacity = cap;
+    }
+
+public:
+    explicit OutputBuffer(size_t reserveBytes = 1 << 16) { grow(max<size_t>(reserveBytes, 64)); }
+
+    char* reserve(size_t n) {
+        if (used + n > capacity) grow(n);
+        return data.get() + used;
+    }
+    void put(char c) {
+        *reserve(1) = c;
+        used++;
+    }
+    void put(string_view s) {
+        if (s.empty()) return;
+        memcpy(reserve(s.size()), s.data(), s.size());
+        used += s.size();
+    }
+    void putInt(long long v) {
+        char* p = reserve(24);
+        used = to_chars(p, p + 24, v).ptr - data.get();
+    }
+
+    // JSON string literal. Bytes >= 0x80 are copied as they are: source text
+    // is expected to be UTF-8.
+    void putJsonString(string_view s) {
+        static const char hex[] = "0123456789abcdef";
+        char* p = reserve(2 + 6 * s.size());
+        char* start = p;
+        *p++ = '"';
+        for (char c : s) {
+            unsigned char u = (unsigned char)c;
+            if (u == '"' || u == '\\') {
+                *p++ = '\\';
+                *p++ = c;
+            } else if (u == '\n') {
+                *p++ = '\\'; *p++ = 'n';
+            } else if (u == '\t') {
+                *p++ = '\\'; *p++ = 't';
+            } else if (u < 0x20) {
+                memcpy(p, "\\u00", 4);
+                p[4] = hex[u >> 4];
+                p[5] = hex[u & 15];
+                p += 6;
+            } else {
+                *p++ = c;
+            }
+        }
+        *p++ = '"';
+        used += p - start;
+    }
+
+    // Binary records: little-endian integers, strings as u32 length + bytes.
+    void putU8(unsigned v) { put((char)v); }
+    void putU32(uint32_t v) {
+        char* p = reserve(4);
+        for (int k = 0; k < 4; k++) p[k] = (char)(v >> (8 * k));
+        used += 4;
+    }
+    void putI32(int v) { putU32((uint32_t)v); }
+    void putBytes(string_view s) {
+        putU32((uint32_t)s.size());
+        put(s);
+    }
+    // For counts only known afterwards: reserve a u32 now, fill it in later.
+    size_t placeholderU32() {
+        size_t at = used;
+        putU32(0);
+        return at;
+    }
+    void patchU32(size_t at, uint32_t v) {
+        for (int k = 0; k < 4; k++) data[at + k] = (char)(v >> (8 * k));
+    }
+
+    size_t size() const { return used; }
+    void clear() { used = 0; }
+    void writeTo(ostream& out) const { out.write(data.get(), used); }
+    // Writes what is buffered and starts over, for output produced in pieces.
+    void drainTo(ostream& out) {
+        writeTo(out);
+        used = 0;
+    }
+};
+
+// One line of the text token listing.
+void putTokenLine(OutputBuffer& buf, const token& t) {
+    buf.put("Type: ");
+    buf.put(tokenToString(t.type));
+    buf.put(", Value: '");
+    buf.put(t.value);
+    buf.put("', Line: ");
+    buf.putInt(t.line);
+    buf.put(", Column: ");
+    buf.putInt(t.col);
+    buf.put('\n');
+}
+
+// ————————————————————————————— Structured Output —————————————————————————————
+// One run's result as a JSON document or binary record stream:
+//
+//   JSON    {"mode":"all","tokens":[…],"ast":{…},"symbols":[…]}
+//           token  {"type":"keyword","value":"int","line":1,"col":1}
+//           node   {"kind":"function","line":1,"col":5,"value":"main","children":[…]}
+//                  ("value" and "children" only when non-empty)
+//           symbol {"name":"x","type":"int","scope":1,"address":"0x1000","value":"5"}
+//           failed runs: {"errors":["…",…],"limitReached":false}
+//
+//   binary  "PVA1", the sections, a 0 byte. A section is a tag byte, a u32
+//           record count and the records, except 'M', which is one string:
+//           'M' mode
+//           'T' token   u8 type, i32 line, i32 col, value
+//           'A' node    u8 kind, u32 child count, i32 line, i32 col, value
+//                       (preorder; each node is followed by its children)
+//           'S' symbol  name, type, i32 scope, u32 address, value
+//           'E' error   message; after the records, u8 limit reached
+//           Strings are a u32 byte length and the bytes.
+//
+// Sections appear only for the phases the mode runs, in phase order; token
+// types and node kinds are the tokenType and nodeKind values.
+class StructuredOutput {
+    OutputBuffer& buf;
+    outputFormat format;
+    bool firstSection = true;
+
+    void section(const char* jsonKey, char tag) {
+        if (format == formatJson) {
+            buf.put(firstSection ? '{' : ',');
+            buf.put('"');
+            buf.put(jsonKey);
+            buf.put("\":");
+        } else {
+            if (firstSection) buf.put("PVA1");
+            buf.putU8(tag);
+        }
+        firstSection = false;
+    }
+
+public:
+    StructuredOutput(OutputBuffer& b, outputFormat f) : buf(b), format(f) {}
+
+    void mode(const string& m) {
+        section("mode", 'M');
+        if (format == formatJson)
+            buf.putJsonString(m);
+        else
+            buf.putBytes(m);
+    }
+
+    void tokens(const vector<token>& toks) {
+        section("tokens", 'T');
+        if (format == formatJson) {
+            buf.put('[');
+            for (size_t k = 0; k < toks.size(); k++)
+                jsonToken(toks[k], k == 0);
+            buf.put(']');
+        } else {
+            buf.putU32((uint32_t)toks.size());
+            for (const token& t : toks) {
+                buf.putU8(t.type);
+                buf.putI32(t.line);
+                buf.putI32(t.col);
+                buf.putBytes(t.value);
+            }
+        }
+    }
+
+    // The tokens straight from `lexer`, without a token vector; the buffer
+    // goes to `out` each time it holds `flushAt` bytes. Returns the number of
+    // tokens. JSON only: a binary section needs its record count up front.
+    size_t tokens(Lexer& lexer, ostream& out, size_t flushAt) {
+        section("tokens", 'T');
+        buf.put('[');
+        token t;
+        size_t count = 0;
+        for (; lexer.next_token(t); count++) {
+            jsonToken(t, count == 0);
+            if (buf.size() >= flushAt)
+                buf.drainTo(out);
+        }
+        buf.put(']');
+        return count;
+    }
+
+    void tree(const ASTNode* root) {
+        section("ast", 'A');
+        if (format == formatJson) {
+            jsonNode(root);  // the root always exists
+        } else {
+            size_t count = buf.placeholderU32();
+            buf.patchU32(count, binaryNode(root));
+        }
+    }
+
+    void symbols(const vector<pair<uint32_t, Symbol>>& entries, const Interner& names) {
+        section("symbols", 'S');
+        if (format == formatJson) {
+            buf.put('[');
+            for (size_t k = 0; k < entries.size(); k++) {
+                const Symbol& sym = entries[k].second;
+                char addr[20];
+                snprintf(addr, sizeof(addr), "0x%04X", sym.memoryAddress);
+                buf.put(k ? ",{\"name\":" : "{\"name\":");
+                buf.putJsonString(names.name(entries[k].first));
+                buf.put(",\"type\":");
+                buf.putJsonString(names.name(sym.type));
+                buf.put(",\"scope\":");
+                buf.putInt(sym.scopeLevel);
+                buf.put(",\"address\":");
+                buf.putJsonString(addr);
+                buf.put(",\"value\":");
+                buf.putJsonString(sym.value);
+                buf.put('}');
+            }
+            buf.put(']');
+        } else {
+            buf.putU32((uint32_t)entries.size());
+            for (auto& [name, sym] : entries) {
+                buf.putBytes(names.name(name));
+                buf.putBytes(names.name(sym.type));
+                buf.putI32(sym.scopeLevel);
+                buf.putU32(sym.memoryAddress);
+                buf.putBytes(sym.value);
+            }
+        }
+    }
+
+    // A failed run's messages; this is the whole document.
+    void errors(const vector<string>& messages, bool limitReached) {
+        section("errors", 'E');
+        if (format == formatJson) {
+            buf.put('[');
+            for (size_t k = 0; k < messages.size(); k++) {
+                if (k) buf.put(',');
+                buf.putJsonString(messages[k]);
+            }
+            buf.put("],\"limitReached\":");
+            buf.put(limitReached ? "true" : "false");
+        } else {
+            buf.putU32((uint32_t)messages.size());
+            for (const string& m : messages)
+                buf.putBytes(m);
+            buf.putU8(limitReached);
+        }
+    }
+
+    void finish() {
+        if (format == formatJson)
+            buf.put(firstSection ? "{}\n" : "}\n");
+        else
+            buf.putU8(0);
+    }
+
+private:
+    void jsonToken(const token& t, bool first) {
+        static const char* const typeNames[] = {
+            "keyword", "identifier", "number", "operator",
+            "separator", "string", "preprocessor", "unknown"
+        };
+        buf.put(first ? "{\"type\":\"" : ",{\"type\":\"");
+        buf.put(typeNames[t.type]);
+        buf.put("\",\"value\":");
+        buf.putJsonString(t.value);
+        buf.put(",\"line\":");
+        buf.putInt(t.line);
+        buf.put(",\"col\":");
+        buf.putInt(t.col);
+        buf.put('}');
+    }
+
+    // Null children (statements that produced nothing) are left out, as in
+    // the text tree. The nodes whose children are still being written wait
+    // on a stack with the index of their next child, so depth is unbounded.
+    void jsonNode(const ASTNode* root) {
+        struct open { const ASTNode* node; unsigned next; bool any; };
+        vector<open> stack;
+        const ASTNode* n = root;
+        while (true) {
+            if (n) {  // a node's fields, up to its children
+                buf.put("{\"kind\":\"");
+                buf.put(nodeKindName(n->kind));
+                buf.put("\",\"line\":");
+                buf.putInt(n->line);
+                buf.put(",\"col\":");
+                buf.putInt(n->col);
+                if (!n->value.empty()) {
+                    buf.put(",\"value\":");
+                    buf.putJsonString(n->value);
+                }
+                stack.push_back({ n, 0, false });
+            }
+            open& top = stack.back();
+            while (top.next < top.node->childCount && !top.node->children[top.next])
+                top.next++;
+            if (top.next < top.node->childCount) {
+                buf.put(top.any ? "," : ",\"children\":[");
+                top.any = true;
+                n = top.node->children[top.next++];
+                continue;
+            }
+            if (top.any) buf.put(']');
+            buf.put('}');
+            stack.pop_back();
+            if (stack.empty())
+                return;
+            n = nullptr;
+        }
+    }
+
+    // Writes the subtree in preorder; returns its node count.
+    uint32_t binaryNode(const ASTNode* root) {
+        vector<const ASTNode*> todo{ root };
+        uint32_t count = 0;
+        while (!todo.empty()) {
+            const ASTNode* n = todo.back();
+            todo.pop_back();
+            unsigned present = 0;
+            for (const ASTNode* child : *n)
+                present += child != nullptr;
+            buf.putU8(n->kind);
+            buf.putU32(present);
+            buf.putI32(n->line);
+            buf.putI32(n->col);
+            buf.putBytes(n->value);
+            count++;
+            for (unsigned k = n->childCount; k-- > 0;)
+                if (n->children[k]) todo.push_back(n->children[k]);
+        }
+        return count;
+    }
+};
+
+// A failed run's diagnostics in `format`; text is Diagnostics::print().
+void writeErrors(const Diagnostics& diags, outputFormat format, ostream& err) {
+    if (format == formatText) {
+        diags.print(err);
+        return;
+    }
+    OutputBuffer buf(256 * (diags.size() + 1));
+    StructuredOutput doc(buf, format);
+    doc.errors(diags.all(), diags.limitReached());
+    doc.finish();
+    buf.writeTo(err);
+}
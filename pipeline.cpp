@@ -0,0 +1,401 @@
+// pipeline.cpp
+#include <bits/stdc++.h>
+#include <sys/resource.h>
+#include "cache.cpp"  // Includes output.cpp → semantic.cpp → syntax.cpp → lexical.cpp
+using namespace std;
+
+// ————————————————————————————— Profiling —————————————————————————————
+// `--profile` times each phase of a run and counts what it produced. The
+// allocation counters are fed by the operator new of allocations.cpp, which
+// the analyzer includes, and only once profiling is switched on; in the
+// library they stay at zero.
+atomic<bool> countAllocations{ false };
+atomic<size_t> allocationCount{ 0 }, allocatedBytes{ 0 };
+
+// Phase times and counters of one run. A phase that runs more than once
+// (output is written after each phase) adds up; phases are listed in the
+// order they first ran.
+struct runProfile {
+    struct phase {
+        string name;
+        double wallMs = 0, cpuMs = 0;  // CPU time is the whole process's, all threads
+        size_t allocations = 0;
+    };
+    vector<phase> phases;
+    size_t inputBytes = 0, tokens = 0, astNodes = 0, symbols = 0, scopePushes = 0;
+    const char* cache = "off";  // or "hit" / "miss" with --cache
+
+    static double cpuMs() {
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    }
+
+    // Runs fn() as part of phase `name`; a throwing fn() is timed too.
+    template <class F>
+    void time(const string& name, F&& fn) {
+        size_t k = 0;
+        while (k < phases.size() && phases[k].name != name) k++;
+        if (k == phases.size()) phases.push_back({ name });
+        size_t allocs = allocationCount;
+        double cpu = cpuMs();
+        auto wall = chrono::steady_clock::now();
+        auto record = [&] {
+            phases[k].wallMs += chrono::duration<double, milli>(chrono::steady_clock::now() - wall).count();
+            phases[k].cpuMs += cpuMs() - cpu;
+            phases[k].allocations += allocationCount - allocs;
+        };
+        try {
+            fn();
+        } catch (...) {
+            record();
+            throw;
+        }
+        record();
+    }
+
+    // One line of JSON, so that scripts can pick it out of stderr:
+    // {"profile":{"input_bytes":…,"cache":"off","phases":[{"name":"lex","wall_ms":…,
+    // "cpu_ms":…,"allocations":…},…],"tokens":…,"ast_nodes":…,"symbols":…,
+    // "scope_pushes":…,"allocations":…,"allocated_bytes":…,"peak_rss_kb":…}}
+    void print(ostream& err) const {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        ostringstream line;
+        line << fixed << setprecision(3) << "{\"profile\":{\"input_bytes\":" << inputBytes << ",\"cache\":\"" << cache
+             << "\",\"phases\":[";
+        for (size_t k = 0; k < phases.size(); k++) {
+            line << (k ? "," : "") << "{\"name\":\"" << phases[k].name << "\",\"wall_ms\":" << phases[k].wallMs
+                 << ",\"cpu_ms\":" << phases[k].cpuMs << ",\"allocations\":" << phases[k].allocations << "}";
+        }
+        line << "],\"tokens\":" << tokens << ",\"ast_nodes\":" << astNodes << ",\"symbols\":" << symbols
+             << ",\"scope_pushes\":" << scopePushes << ",\"allocations\":" << allocationCount
+             << ",\"allocated_bytes\":" << allocatedBytes << ",\"peak_rss_kb\":" << usage.ru_maxrss << "}}\n";
+        err << line.str();
+    }
+};
+
+size_t countNodes(const ASTNode* root) {
+    vector<const ASTNode*> todo{ root };
+    size_t count = 0;
+    while (!todo.empty()) {
+        const ASTNode* n = todo.back();
+        todo.pop_back();
+        count++;
+        for (const ASTNode* child : *n)
+            if (child) todo.push_back(child);
+    }
+    return count;
+}
+
+// Output is handed to the stream in pieces of about this size.
+constexpr size_t outputChunk = 1 << 16;
+
+void printTokens(const vector<token>& toks, ostream& out) {
+    OutputBuffer buf(outputChunk + 1024);
+    for (const auto& t : toks) {
+        putTokenLine(buf, t);
+        if (buf.size() >= outputChunk)
+            buf.drainTo(out);
+    }
+    buf.drainTo(out);
+}
+
+// Command-line settings that apply to every run.
+struct runOptions {
+    size_t maxErrors = Diagnostics::defaultLimit;  // 0 = no limit
+    unsigned threads = 1;                           // for lexing large inputs
+    outputFormat format = formatText;
+    runProfile* profile = nullptr;                  // --profile: where the run is recorded
+    ResultCache* cache = nullptr;                   // --cache: finished runs on disk
+};
+
+// Runs fn() as phase `name` of the run's profile, if it has one.
+template <class F>
+void timed(const runOptions& opts, const char* name, F&& fn) {
+    if (opts.profile)
+        opts.profile->time(name, fn);
+    else
+        fn();
+}
+
+bool validMode(const string& mode) {
+    return mode == "lexical" || mode == "syntax" || mode == "semantic" || mode == "all";
+}
+
+// One run of the phases after lexing. The SemanticAnalyzer reports into
+// `diags`, so a phaseRun stays where it was made.
+struct phaseRun {
+    Diagnostics diags;
+    optional<Parser> local;
+    optional<SemanticAnalyzer> sem;
+    phaseResults results;
+
+    explicit phaseRun(size_t maxErrors) : diags(maxErrors) {}
+    phaseRun(const phaseRun&) = delete;
+    phaseRun& operator=(const phaseRun&) = delete;
+};
+
+// Runs the phases after lexing that `mode` needs, or every one of them with
+// `everyPhase` (for a cache snapshot, which serves all modes), over tokens
+// whose IDs come from `names`. With `reuse`, that Parser builds the tree, or
+// only updates its previous tree if `change` says how the tokens changed since.
+void computePhases(phaseRun& run, const string& mode, const vector<token>& toks, const Interner& names,
+                   const runOptions& opts, bool everyPhase,
+                   Parser* reuse = nullptr, const tokenChange* change = nullptr) {
+    phaseResults& r = run.results;
+    r.toks = &toks;
+    r.names = &names;
+    if (mode == "lexical" && !everyPhase)
+        return;
+    try {
+        Parser& p = reuse ? *reuse : run.local.emplace(toks, names);
+        ASTNode* root = nullptr;
+        r.parsed = true;
+        timed(opts, "parse", [&] {
+            root = reuse && change ? p.reparse(toks, *change, run.diags) : p.parse(run.diags);
+        });
+        if (opts.profile)
+            opts.profile->astNodes = countNodes(root);
+        if (run.diags.empty()) {
+            r.root = root;
+            if (mode != "syntax" || everyPhase) {
+                r.checked = true;
+                SemanticAnalyzer& sem = run.sem.emplace(names, run.diags, opts.threads);
+                bool clean = false;
+                timed(opts, "semantic", [&] { clean = sem.check(root); });
+                if (clean)
+                    r.symbols = &sem.symbols();
+            }
+        }
+    } catch (const ErrorLimitReached&) {
+        // diags holds everything up to the limit
+    }
+    if (opts.profile && run.sem) {
+        opts.profile->symbols = run.sem->symbols().size();
+        opts.profile->scopePushes = run.sem->scopePushes();
+    }
+}
+
+// Writes what `mode` shows of a run: its phase output on `out`, and if one of
+// the mode's phases failed, that phase's errors on `err`. Returns the exit status.
+int emitResults(const string& mode, const phaseResults& r, const Diagnostics& diags,
+                ostream& out, ostream& err, const runOptions& opts) {
+    bool showTokens = mode == "lexical" || mode == "all";
+    bool showTree = mode == "syntax" || mode == "all";
+    bool showSymbols = mode == "semantic" || mode == "all";
+    bool clean = mode == "lexical" || (r.root && (mode == "syntax" || r.symbols));
+    bool text = opts.format == formatText;
+    int status = clean ? 0 : 1;
+    timed(opts, "output", [&] {
+        if (text) {
+            // Text output shows every phase that got as far as output, even if
+            // a later one failed.
+            bool all = mode == "all";
+            if (showTokens) {
+                if (all) out << "==== Lexical Analysis ====\n";
+                printTokens(*r.toks, out);
+            }
+            if (showTree && r.root) {
+                if (all) out << "\n==== Syntax Analysis ====\n";
+                printTree(r.root, out);
+            }
+            if (showSymbols && r.root) {
+                if (all) out << "\n==== Semantic Analysis ====\n";
+                if (r.symbols) {
+                    printSymbolTable(*r.symbols, *r.names, out);
+                    out << "Semantic Analysis Successful.\n";
+                }
+            }
+            if (status)
+                diags.print(err);
+        } else if (status) {
+            writeErrors(diags, opts.format, err);
+        } else {
+            // Structured output is collected and written in one piece.
+            OutputBuffer buf(r.toks->size() * (mode == "lexical" ? 64 : 160));
+            StructuredOutput doc(buf, opts.format);
+            doc.mode(mode);
+            if (showTokens) doc.tokens(*r.toks);
+            if (showTree) doc.tree(r.root);
+            if (showSymbols) doc.symbols(*r.symbols, *r.names);
+            doc.finish();
+            buf.writeTo(out);
+        }
+    });
+    return status;
+}
+
+// A failure before any phase ran, in the run's output format.
+int reportFailure(const string& msg, const runOptions& opts, ostream& err) {
+    Diagnostics diags(0);
+    diags.report(msg);
+    writeErrors(diags, opts.format, err);
+    return 1;
+}
+
+// Lexical mode without the token vector: each token is formatted as the
+// Lexer produces it and the buffer is written out whenever it fills, so
+// memory stays at one buffer however large the input, and output starts with
+// the first token. It runs on one thread; binary output needs the token
+// count before the tokens and takes the vector path instead. Lexing and
+// output are interleaved, so the profile has one "lex+output" phase.
+int streamTokens(string_view code, ostream& out, const runOptions& opts) {
+    Interner names;
+    Lexer lexer(code, names);
+    OutputBuffer buf(outputChunk + 1024);
+    size_t count = 0;
+    timed(opts, "lex+output", [&] {
+        if (opts.format == formatJson) {
+            StructuredOutput doc(buf, opts.format);
+            doc.mode("lexical");
+            count = doc.tokens(lexer, out, outputChunk);
+            doc.finish();
+        } else {
+            token t;
+            for (; lexer.next_token(t); count++) {
+                putTokenLine(buf, t);
+                if (buf.size() >= outputChunk)
+                    buf.drainTo(out);
+            }
+        }
+        buf.drainTo(out);
+    });
+    if (opts.profile)
+        opts.profile->tokens = count;
+    return 0;
+}
+
+// Runs one analysis over `code`, writing the phase output to `out`.
+// Errors are written to `err`; returns the process-style exit status.
+//
+// Every mode tokenizes and parses at most once: "semantic" checks the tree
+// built by the parser, and "all" prints all three phases from that one pass.
+// Each phase reports all of its errors, up to opts.maxErrors for the run; the
+// semantic phase only runs on a tree without syntax errors, since checking
+// a tree with statements missing would mostly report knock-on errors.
+//
+// With a cache, a source analyzed before is answered from its snapshot, and
+// a new one runs every phase whatever the mode, so that the snapshot serves
+// the other modes too.
+int runMode(const string& mode, string_view code, ostream& out, ostream& err,
+            const runOptions& opts = runOptions()) {
+    if (!validMode(mode))
+        return reportFailure("Invalid mode.", opts, err);
+    if (opts.profile)
+        opts.profile->inputBytes = code.size();
+    string key;
+    if (opts.cache) {
+        unique_ptr<cachedRun> hit;
+        timed(opts, "cache", [&] {
+            key = opts.cache->keyFor(code, opts.maxErrors);
+            hit = opts.cache->find(key, code);
+        });
+        if (opts.profile)
+            opts.profile->cache = hit ? "hit" : "miss";
+        if (hit) {
+            const phaseResults& r = hit->results;
+            if (opts.profile) {
+                opts.profile->tokens = r.toks->size();
+                opts.profile->astNodes = r.root ? countNodes(r.root) : 0;
+                opts.profile->symbols = r.symbols ? r.symbols->size() : 0;
+            }
+            return emitResults(mode, r, hit->diags, out, err, opts);
+        }
+    } else if (mode == "lexical" && opts.format != formatBinary) {
+        return streamTokens(code, out, opts);
+    }
+    Interner names;  // one per run, shared by every phase
+    vector<token> toks;
+    timed(opts, "lex", [&] { toks = tokenizeParallel(code, names, opts.threads); });
+    if (opts.profile)
+        opts.profile->tokens = toks.size();
+    phaseRun run(opts.maxErrors);
+    computePhases(run, mode, toks, names, opts, opts.cache != nullptr);
+    if (opts.cache)
+        timed(opts, "cache", [&] { opts.cache->store(key, code, run.results, run.diags); });
+    return emitResults(mode, run.results, run.diags, out, err, opts);
+}
+
+// ————————————————————————————— Documents —————————————————————————————
+
+// An editable document (a server connection's, or a C API handle's), its
+// tokens and its tree. The text is held
+// through a pointer so the tokens' views stay put when the document is
+// replaced. `toks` is only current while `lexed` is set, which a cache hit
+// clears. `parser` is null until a request parses the document, and again
+// after a lexical-mode edit, which leaves the tree behind the tokens.
+//
+// A document lives as long as its connection or handle, so neither its
+// names nor its parser's arena may grow with the number of edits: relex()
+// interns every name it meets, including each prefix of a name being
+// typed, and reparse() leaves the nodes it replaces in the arena. Each is
+// started afresh (a full tokenize() or parse()) once its garbage could
+// outweigh what is in use, which keeps a document's memory proportional to
+// its text and the cost of starting over amortized over the edits.
+struct document {
+    unique_ptr<string> code = make_unique<string>();
+    unique_ptr<Interner> names = make_unique<Interner>();
+    vector<token> toks;
+    bool lexed = false;
+    unique_ptr<Parser> parser;
+};
+
+// Makes `next` the document's text, produced from the current one by `edit`
+// if that is set, and analyzes it.
+int analyzeDocument(document& doc, unique_ptr<string> next, const textEdit* edit,
+                    const string& mode, ostream& out, ostream& err, const runOptions& opts) {
+    string key;
+    if (opts.cache) {
+        key = opts.cache->keyFor(*next, opts.maxErrors);
+        if (auto hit = opts.cache->find(key, *next)) {
+            doc.code = move(next);
+            doc.toks.clear();
+            doc.lexed = false;
+            doc.parser.reset();
+            return emitResults(mode, hit->results, hit->diags, out, err, opts);
+        }
+    }
+    optional<tokenChange> change;
+    bool namesInBounds = doc.names->size() <= 2 * (fixedSymbolCount + doc.toks.size());
+    if (edit && doc.lexed && namesInBounds) {
+        change = relex(doc.toks, *doc.code, *next, *edit, *doc.names);
+    } else {
+        doc.parser.reset();  // its tree refers to the names
+        doc.names = make_unique<Interner>();
+        doc.toks = tokenizeParallel(*next, *doc.names, opts.threads);
+    }
+    doc.code = move(next);
+    doc.lexed = true;
+
+    bool everyPhase = opts.cache != nullptr;
+    phaseRun run(opts.maxErrors);
+    if (mode == "lexical" && !everyPhase) {
+        doc.parser.reset();
+        computePhases(run, mode, doc.toks, *doc.names, opts, everyPhase);
+    } else {
+        if (!doc.parser) {
+            doc.parser = make_unique<Parser>(doc.toks, *doc.names);
+            change.reset();  // nothing to update: parse from scratch
+        }
+        computePhases(run, mode, doc.toks, *doc.names, opts, everyPhase, doc.parser.get(),
+                      change ? &*change : nullptr);
+    }
+    if (opts.cache)
+        opts.cache->store(key, *doc.code, run.results, run.diags);
+    int status = emitResults(mode, run.results, run.diags, out, err, opts);
+    if (doc.parser && doc.parser->deadBytes() > doc.parser->liveBytes())
+        doc.parser.reset();  // the next request parses into a fresh arena
+    return status;
+}
+
+// The smallest single edit turning `from` into `to`.
+textEdit diffEdit(string_view from, string_view to) {
+    size_t limit = min(from.size(), to.size());
+    size_t prefix = 0, suffix = 0;
+    while (prefix < limit && from[prefix] == to[prefix])
+        prefix++;
+    while (suffix < limit - prefix && from[from.size() - 1 - suffix] == to[to.size() - 1 - suffix])
+        suffix++;
+    return { prefix, from.size() - prefix - suffix, to.substr(prefix, to.size() - prefix - suffix) };
+}
@@ -1,368 +1,568 @@
 // semantic.cpp
 #include <bits/stdc++.h>
-#include "syntax.cpp"   // brings in Parser, tokenize(), token, etc.
+#include "syntax.cpp"   // brings in Parser, ASTNode, tokenize(), token, etc.
 using namespace std;
 
 // —————————————————————————————————————————————————————————————
 // A “Symbol” entry: stores type, scope level, memory address, and value.
 // —————————————————————————————————————————————————————————————
 struct Symbol {
-    string type;             // e.g. "int", "float", "char", ...
+    uint32_t type;           // type keyword ID, e.g. kwInt, kwFloat, kwChar, ...
     int scopeLevel;          // 0 = global, 1 = first nested block, etc.
-    string memoryAddress;    // mock hex address, e.g. "0x1000"
+    unsigned memoryAddress;  // mock address, printed in hex, e.g. "0x1000"
     string value;            // either literal or "Uninitialized"
 };
 
 // —————————————————————————————————————————————————————————————
-// The SemanticAnalyzer builds a vector of (name → Symbol) entries
-// and, at the end, prints a 5-column ASCII table: Name | Type | Scope | Memory Address | Value
+// Scoped symbol table: one flat table for all scopes. Every name ID heads a
+// chain of its bindings, innermost first, so a lookup is one hash probe plus
+// one array read no matter how deeply scopes nest. The bindings vector is the
+// undo log: leaving a scope pops the bindings made since it was entered and
+// restores each name's previous (shadowed) binding.
 // —————————————————————————————————————————————————————————————
-class SemanticAnalyzer {
-    vector<token> tokens;
-    int current = 0;
-    int currentScopeLevel = 0;
-
-    // Stack of “maps” from (name → Symbol) for each scope level:
-    vector<map<string, Symbol>> symbolTableStack;
-
-    // Preserve insertion order so we can print in declaration order:
-    vector<pair<string, Symbol>> symbolEntries;
-
-    // Next mock address (4-byte increments) starting at 0x1000:
-    unsigned int nextAddress = 0x1000;
+class ScopedSymbolTable {
+    struct Binding {
+        uint32_t name;   // interned name ID
+        int symbol;      // caller's symbol index
+        int scope;       // scope level it was declared at
+        int shadowed;    // previous binding of the same name, or -1
+    };
+
+    vector<int> innermost;      // name ID → index into bindings, or -1
+    vector<Binding> bindings;
+    vector<size_t> scopeStart;  // bindings.size() when each open scope began
+    size_t opened = 0;          // pushScope() calls so far
 
 public:
-    SemanticAnalyzer(const vector<token>& t)
-      : tokens(t)
-    {
-        // Start with one global scope (level 0):
-        symbolTableStack.push_back({});
+    int level() const { return (int)scopeStart.size(); }
+    size_t scopesOpened() const { return opened; }
+
+    void pushScope() {
+        scopeStart.push_back(bindings.size());
+        opened++;
     }
 
-    void analyze() {
-        // Walk all top-level statements/blocks:
-        while (!isAtEnd()) {
-            statement();
+    void popScope() {
+        size_t mark = scopeStart.back();
+        scopeStart.pop_back();
+        while (bindings.size() > mark) {
+            innermost[bindings.back().name] = bindings.back().shadowed;
+            bindings.pop_back();
         }
-        // Print the 5-column symbol table:
-        printSymbolTable();
-        cout << "Semantic Analysis Successful.\n";
     }
 
-private:
-    // ————————————————————————————— Token Utilities —————————————————————————————
-    token peek() {
-        if (current < (int)tokens.size())
-            return tokens[current];
-        return token{ unknown, "", -1, -1 };
+    // Symbol index of the innermost visible binding of `name`, or -1.
+    int lookup(uint32_t name) const {
+        if (name >= innermost.size() || innermost[name] < 0) return -1;
+        return bindings[innermost[name]].symbol;
     }
 
-    token advance() {
-        return tokens[current++];
+    bool declaredInCurrentScope(uint32_t name) const {
+        if (name >= innermost.size() || innermost[name] < 0) return false;
+        return bindings[innermost[name]].scope == level();
     }
 
-    bool match(tokenType ty, const string& v = "") {
-        if (current < (int)tokens.size() &&
-            tokens[current].type == ty &&
-            (v.empty() || tokens[current].value == v))
-        {
-            current++;
-            return true;
-        }
-        return false;
+    void declare(uint32_t name, int symbol) {
+        if (name >= innermost.size()) innermost.resize(name + 1, -1);
+        bindings.push_back({ name, symbol, level(), innermost[name] });
+        innermost[name] = (int)bindings.size() - 1;
     }
+};
 
-    bool check(tokenType ty, const string& v = "") {
-        if (current >= (int)tokens.size()) return false;
-        return (tokens[current].type == ty) &&
-               (v.empty() || tokens[current].value == v);
+// ————————————————————————————— Print 5-Column Symbol Table —————————————————————————————
+void printSymbolTable(const vector<pair<uint32_t, Symbol>>& symbolEntries, const Interner& names, ostream& out) {
+    if (symbolEntries.empty()) {
+        out << "No symbols declared.\n";
+        return;
     }
 
-    bool isAtEnd() {
-        return current >= (int)tokens.size();
+    // Determine max width of each column:
+    size_t nameW   = strlen("Name");
+    size_t typeW   = strlen("Type");
+    size_t scopeW  = strlen("Scope");
+    size_t addrW   = strlen("Memory Address");
+    size_t valueW  = strlen("Value");
+
+    auto address = [](unsigned addr) {
+        char buf[20];
+        snprintf(buf, sizeof(buf), "0x%04X", addr);
+        return string(buf);
+    };
+
+    for (auto& pr : symbolEntries) {
+        const Symbol& sym = pr.second;
+        nameW   = max(nameW, names.name(pr.first).size());
+        typeW   = max(typeW, names.name(sym.type).size());
+        // Scope as string
+        string sScope = to_string(sym.scopeLevel);
+        scopeW  = max(scopeW, sScope.size());
+        addrW   = max(addrW, address(sym.memoryAddress).size());
+        valueW  = max(valueW, sym.value.size());
     }
 
-    token peekNext(int offset = 1) {
-        int idx = current + offset;
-        if (idx < (int)tokens.size())
-            return tokens[idx];
-        return token{ unknown, "", -1, -1 };
+    // Build a horizontal border: +--nameW--+--typeW--+--scopeW--+--addrW--+--valueW--+
+    auto mkBorder = [&]() {
+        string border = "+";
+        border += string(nameW  + 2, '-') + "+";
+        border += string(typeW  + 2, '-') + "+";
+        border += string(scopeW + 2, '-') + "+";
+        border += string(addrW  + 2, '-') + "+";
+        border += string(valueW + 2, '-') + "+";
+        return border;
+    };
+
+    string border = mkBorder();
+
+    // Header row:
+    out << border << "\n";
+    out << "| " << left << setw(nameW)   << "Name"
+         << " | " << left << setw(typeW)   << "Type"
+         << " | " << right << setw(scopeW) << "Scope"
+         << " | " << left << setw(addrW)   << "Memory Address"
+         << " | " << left << setw(valueW)  << "Value"
+         << " |\n";
+    out << border << "\n";
+
+    // Each entry row:
+    for (auto& pr : symbolEntries) {
+        const Symbol& sym = pr.second;
+        string sScope = to_string(sym.scopeLevel);
+
+        out << "| " << left << setw(nameW)   << names.name(pr.first)
+             << " | " << left << setw(typeW)   << names.name(sym.type)
+             << " | " << right << setw(scopeW) << sScope
+             << " | " << left << setw(addrW)   << address(sym.memoryAddress)
+             << " | " << left << setw(valueW)  << sym.value
+             << " |\n";
     }
+    out << border << "\n";
+}
 
-    void error(const string& msg) {
-        token t = peek();
-        if (t.line == -1) {
-            cerr << "Semantic Error: " << msg << " (unexpected end of input)\n";
-        } else {
-            cerr << "Semantic Error at line " << t.line
-                 << ", column " << t.col << ": " << msg << "\n";
-        }
-        exit(1);
+// —————————————————————————————————————————————————————————————
+// The SemanticAnalyzer walks the AST produced by Parser::parse(), builds a
+// vector of (name → Symbol) entries and, at the end, prints a 5-column ASCII
+// table: Name | Type | Scope | Memory Address | Value
+// Names and types are interned IDs until the table is printed.
+//
+// With more than one thread, top-level function bodies are checked in
+// parallel: the top-level pass declares every global and function name but
+// only notes each body together with how many globals were declared before
+// it. Once that pass is done the globals no longer change, so each body is
+// checked by its own SemanticAnalyzer that sees the frozen globals up to its
+// mark, and the bodies' symbols and errors are spliced back in at the points
+// where the sequential walk would have produced them.
+// —————————————————————————————————————————————————————————————
+class SemanticAnalyzer {
+    const Interner& names;  // The interner tokenize() filled
+    Diagnostics& diags;     // Where semantic errors are reported
+    unsigned threads;       // Upper bound on concurrent function bodies
+
+    // Visible names → index into symbolEntries, for every open scope:
+    ScopedSymbolTable scopes;
+
+    // Preserve insertion order so we can print in declaration order:
+    vector<pair<uint32_t, Symbol>> symbolEntries;
+
+    // Errors in walk order, reported when the walk is complete:
+    vector<string> errors;
+
+    // Next mock address (4-byte increments) starting at 0x1000:
+    unsigned int nextAddress = 0x1000;
+
+    // A function body left for later, with what had been produced before it.
+    struct deferredBody {
+        const ASTNode* body;
+        size_t globalsBefore;  // globals visible to it (its own name included)
+        size_t entriesBefore;  // symbolEntries.size() at that point
+        size_t errorsBefore;   // errors.size() at that point
+    };
+
+    bool deferring = false;               // in the top-level pass of a parallel run
+    vector<deferredBody> bodies;
+    vector<int> globalDecls;              // level-0 symbolEntries indices, in order
+    vector<int> globalOrder;              // name ID → position in globalDecls, or -1
+
+    // Set on the analyzers that check one deferred body:
+    const SemanticAnalyzer* globals = nullptr;
+    size_t globalsVisible = 0;
+
+    size_t bodyScopePushes = 0;           // scopes the deferred bodies' analyzers entered
+
+    // The walks keep their own stacks rather than recursing, so any depth
+    // of nesting is checked; these are reused from walk to walk.
+    vector<const ASTNode*> walk;                      // statements still to check
+    vector<pair<const ASTNode*, bool>> operandWalk;   // expression nodes; true once their operands are queued
+    vector<uint32_t> operandTypes;                    // types of the finished operands
+
+public:
+    // Starts in the global scope (level 0).
+    SemanticAnalyzer(const Interner& n, Diagnostics& d, unsigned t = 1) : names(n), diags(d), threads(t) {}
+
+    // Checks the whole tree, recording every error in `diags`; the symbol
+    // table is printed only if there were none.
+    void analyze(const ASTNode* root, ostream& out = cout) {
+        if (check(root))
+            print(out);
     }
 
-    // Return reference to current (innermost) scope’s map:
-    map<string, Symbol>& currentScope() {
-        return symbolTableStack.back();
+    // The 5-column symbol table and the success line.
+    void print(ostream& out) {
+        printSymbolTable(symbolEntries, names, out);
+        out << "Semantic Analysis Successful.\n";
     }
 
-    // Search through scopes to see if name was declared:
-    bool isDeclared(const string& name) {
-        for (int i = (int)symbolTableStack.size() - 1; i >= 0; --i) {
-            if (symbolTableStack[i].count(name)) return true;
+    // The checks of analyze() without the printing; true if there were no
+    // errors, and symbols() is then the table.
+    bool check(const ASTNode* root) {
+        deferring = threads > 1;
+        // Walk all top-level statements/blocks:
+        for (const ASTNode* stmt : *root) {
+            statement(stmt);
         }
-        return false;
+        deferring = false;
+        if (!bodies.empty())
+            checkBodies();
+
+        for (const string& e : errors)
+            diags.report(e);
+        return errors.empty();
     }
 
-    // Look up type of name from innermost → outermost:
-    string getType(const string& name) {
-        for (int i = (int)symbolTableStack.size() - 1; i >= 0; --i) {
-            auto& tbl = symbolTableStack[i];
-            if (tbl.count(name)) {
-                return tbl[name].type;
+    // Every declaration, in declaration order.
+    const vector<pair<uint32_t, Symbol>>& symbols() const { return symbolEntries; }
+
+    // Block scopes entered, the deferred bodies' included.
+    size_t scopePushes() const { return scopes.scopesOpened() + bodyScopePushes; }
+
+private:
+    // The analyzer for one deferred body of `owner`.
+    SemanticAnalyzer(const SemanticAnalyzer& owner, size_t visible)
+        : names(owner.names), diags(owner.diags), threads(1), globals(&owner), globalsVisible(visible) {}
+
+    // Checks the deferred bodies on up to `threads` threads, then splices
+    // their symbols and errors in at their places in the walk order.
+    void checkBodies() {
+        globalOrder.assign(names.size(), -1);
+        for (size_t k = 0; k < globalDecls.size(); k++)
+            globalOrder[symbolEntries[globalDecls[k]].first] = (int)k;
+
+        // One analyzer per thread, reused for every body that thread takes;
+        // each body leaves its scopes closed again.
+        struct bodyResult {
+            vector<pair<uint32_t, Symbol>> symbolEntries;
+            vector<string> errors;
+        };
+        vector<bodyResult> checked(bodies.size());
+        atomic<size_t> next{ 0 }, pushes{ 0 };
+        parallelFor(min<size_t>(threads, bodies.size()), [&](size_t) {
+            SemanticAnalyzer worker(*this, 0);
+            for (size_t k; (k = next++) < bodies.size();) {
+                worker.globalsVisible = bodies[k].globalsBefore;
+                worker.statement(bodies[k].body);
+                checked[k].symbolEntries = move(worker.symbolEntries);
+                checked[k].errors = move(worker.errors);
+                worker.symbolEntries.clear();
+                worker.errors.clear();
             }
+            pushes += worker.scopes.scopesOpened();
+        });
+        bodyScopePushes += pushes;
+
+        vector<pair<uint32_t, Symbol>> entries;
+        vector<string> allErrors;
+        size_t entryPos = 0, errorPos = 0;
+        for (size_t k = 0; k < bodies.size(); k++) {
+            const deferredBody& b = bodies[k];
+            entries.insert(entries.end(), symbolEntries.begin() + entryPos, symbolEntries.begin() + b.entriesBefore);
+            entries.insert(entries.end(), checked[k].symbolEntries.begin(), checked[k].symbolEntries.end());
+            allErrors.insert(allErrors.end(), errors.begin() + errorPos, errors.begin() + b.errorsBefore);
+            allErrors.insert(allErrors.end(), checked[k].errors.begin(), checked[k].errors.end());
+            entryPos = b.entriesBefore;
+            errorPos = b.errorsBefore;
         }
-        return "";
+        entries.insert(entries.end(), symbolEntries.begin() + entryPos, symbolEntries.end());
+        allErrors.insert(allErrors.end(), errors.begin() + errorPos, errors.end());
+
+        // Addresses follow the final declaration order.
+        for (size_t k = 0; k < entries.size(); k++)
+            entries[k].second.memoryAddress = 0x1000 + 4 * (unsigned)k;
+        symbolEntries = move(entries);
+        errors = move(allErrors);
+        bodies.clear();
     }
 
-    // int ↔ float compatibility; otherwise must match exactly:
-    bool typesCompatible(const string& lhs, const string& rhs) {
-        if (lhs == rhs) return true;
-        const set<string> num = { "int", "float" };
-        if (num.count(lhs) && num.count(rhs)) return true;
-        return false;
-    }
-
-    // ————————————————————————————— Print 5-Column Symbol Table —————————————————————————————
-    void printSymbolTable() {
-        if (symbolEntries.empty()) {
-            cout << "No symbols declared.\n";
+    // Records the error and lets the caller carry on with the next check.
+    // The position is that of `at`'s first token, so an undeclared assignment
+    // target or a redeclared variable is reported at its name: `x = 1;` at
+    // the `x`, not at the `=` after it as when these checks re-parsed the
+    // tokens.
+    void error(const string& msg, const ASTNode* at) {
+        if (at->line == -1) {
+            errors.push_back("Semantic Error: " + msg + " (unexpected end of input)");
             return;
         }
+        errors.push_back("Semantic Error at line " + to_string(at->line) +
+                         ", column " + to_string(at->col) + ": " + msg);
+    }
+
+    string text(uint32_t id) {
+        return string(names.name(id));
+    }
 
-        // Determine max width of each column:
-        size_t nameW   = strlen("Name");
-        size_t typeW   = strlen("Type");
-        size_t scopeW  = strlen("Scope");
-        size_t addrW   = strlen("Memory Address");
-        size_t valueW  = strlen("Value");
-
-        for (auto& pr : symbolEntries) {
-            const string& nm  = pr.first;
-            const Symbol& sym = pr.second;
-            nameW   = max(nameW, nm.size());
-            typeW   = max(typeW, sym.type.size());
-            // Scope as string
-            string sScope = to_string(sym.scopeLevel);
-            scopeW  = max(scopeW, sScope.size());
-            addrW   = max(addrW, sym.memoryAddress.size());
-            valueW  = max(valueW, sym.value.size());
+    // Innermost visible declaration of name, or null. A deferred body's
+    // analyzer falls back to the globals declared before that body.
+    const Symbol* find(uint32_t name) {
+        int idx = scopes.lookup(name);
+        if (idx >= 0)
+            return &symbolEntries[idx].second;
+        if (globals && name < globals->globalOrder.size()) {
+            int pos = globals->globalOrder[name];
+            if (pos >= 0 && (size_t)pos < globalsVisible)
+                return &globals->symbolEntries[globals->globalDecls[pos]].second;
         }
+        return nullptr;
+    }
 
-        // Build a horizontal border: +--nameW--+--typeW--+--scopeW--+--addrW--+--valueW--+
-        auto mkBorder = [&]() {
-            string border = "+";
-            border += string(nameW  + 2, '-') + "+";
-            border += string(typeW  + 2, '-') + "+";
-            border += string(scopeW + 2, '-') + "+";
-            border += string(addrW  + 2, '-') + "+";
-            border += string(valueW + 2, '-') + "+";
-            return border;
-        };
+    // Is name visible from the current scope?
+    bool isDeclared(uint32_t name) {
+        return find(name) != nullptr;
+    }
 
-        string border = mkBorder();
+    // Type of the innermost visible declaration of name:
+    uint32_t getType(uint32_t name) {
+        const Symbol* sym = find(name);
+        return sym ? sym->type : Interner::none;
+    }
 
-        // Header row:
-        cout << border << "\n";
-        cout << "| " << left << setw(nameW)   << "Name"
-             << " | " << left << setw(typeW)   << "Type"
-             << " | " << right << setw(scopeW) << "Scope"
-             << " | " << left << setw(addrW)   << "Memory Address"
-             << " | " << left << setw(valueW)  << "Value"
-             << " |\n";
-        cout << border << "\n";
-
-        // Each entry row:
-        for (auto& pr : symbolEntries) {
-            const string& nm = pr.first;
-            const Symbol& sym = pr.second;
-            string sScope = to_string(sym.scopeLevel);
-
-            cout << "| " << left << setw(nameW)   << nm
-                 << " | " << left << setw(typeW)   << sym.type
-                 << " | " << right << setw(scopeW) << sScope
-                 << " | " << left << setw(addrW)   << sym.memoryAddress
-                 << " | " << left << setw(valueW)  << sym.value
-                 << " |\n";
-        }
-        cout << border << "\n";
+    // int ↔ float compatibility; otherwise must match exactly. An operand
+    // whose type is unknown (already reported) is compatible with anything:
+    bool typesCompatible(uint32_t lhs, uint32_t rhs) {
+        if (lhs == rhs || lhs == Interner::none || rhs == Interner::none) return true;
+        auto numeric = [](uint32_t t) { return t == kwInt || t == kwFloat; };
+        return numeric(lhs) && numeric(rhs);
     }
 
-    // ————————————————————————————— Top-Level Statement Dispatcher —————————————————————————————
-    void statement() {
-        // 1) Block “{ … }”
-        if (match(separator, "{")) {
-            symbolTableStack.push_back({});   // new nested scope
-            currentScopeLevel++;
+    // ————————————————————————————— Statement Dispatcher —————————————————————————————
+    // Checks `root` and everything nested in it, in source order. Nested
+    // statements are queued on `walk` (in reverse, so the first comes off
+    // first) and a null entry closes the scope its block opened.
+    void statement(const ASTNode* root) {
+        if (!root) return;  // empty statement, e.g. a lone ';'
+        size_t outer = walk.size();
+        walk.push_back(root);
+        while (walk.size() > outer) {
+            const ASTNode* node = walk.back();
+            walk.pop_back();
+            if (!node) {
+                scopes.popScope();
+                continue;
+            }
 
-            while (!match(separator, "}")) {
-                if (isAtEnd()) {
-                    error("Unclosed block in semantic analysis");
+            switch (node->kind) {
+            // 1) Block “{ … }”
+            case astBlock:
+                scopes.pushScope();   // new nested scope
+                walk.push_back(nullptr);
+                queue(node, 0);
+                break;
+
+            // 2) Function: its name is a symbol of the enclosing scope, its body a nested block
+            case astFunction:
+                declare(node->children[1], node->children[0]->sym, "Function");
+                if (deferring && scopes.level() == 0) {
+                    bodies.push_back({ node->children[2], globalDecls.size(), symbolEntries.size(), errors.size() });
+                    break;
                 }
-                statement();
-            }
+                queue(node, 2);
+                break;
+
+            // 3) Declaration: int x;  or  float y = 3;
+            case astDeclaration:
+                declaration(node);
+                break;
+
+            // 4) Assignment: x = expr;
+            case astAssignment:
+                assignment(node, "in assignment");
+                break;
+
+            // 5) Control flow: check the conditions, then the bodies
+            case astIf:
+            case astWhile:
+                expressionType(node->children[0], "in expression");
+                queue(node, 1);
+                break;
+
+            case astFor:
+                assignment(node->children[0], "in assignment");
+                expressionType(node->children[1], "in expression");
+                assignment(node->children[2], "in assignment");
+                queue(node, 3);
+                break;
+
+            // 6) I/O and return: every identifier they mention must be declared
+            case astCout:
+            case astCin:
+                for (const ASTNode* value : *node) {
+                    if (value->kind == astIdentifier)
+                        expressionType(value, "in expression");
+                }
+                break;
 
-            symbolTableStack.pop_back();
-            currentScopeLevel--;
-        }
-        // 2) Declaration: int x;  or  float y = 3;
-        else if (check(keyword, "int")   ||
-                 check(keyword, "float") ||
-                 check(keyword, "char")  ||
-                 check(keyword, "bool"))
-        {
-            declaration();
-            match(separator, ";");  // consume trailing “;” if present
-        }
-        // 3) Assignment: x = expr;
-        else if (check(identifier) &&
-                 peekNext().type == operaTor &&
-                 peekNext().value == "=")
-        {
-            assignment();
-            match(separator, ";");
-        }
-        // 4) Otherwise skip (including stray semicolons)
-        else {
-            advance();
+            case astReturn:
+                if (node->childCount)
+                    expressionType(node->children[0], "in expression");
+                break;
+
+            default:
+                break;
+            }
         }
     }
 
-    // ————————————————————————————— Declarations —————————————————————————————
-    void declaration() {
-        // Next token is a type keyword
-        string varType = advance().value;  // e.g. "int", "float", …
+    // Queues node's children from `first` on, skipping empty statements.
+    void queue(const ASTNode* node, unsigned first) {
+        for (unsigned i = node->childCount; i-- > first;)
+            if (node->children[i])
+                walk.push_back(node->children[i]);
+    }
 
-        if (!match(identifier)) {
-            error("Expected variable name after type");
-        }
-        string varName = tokens[current - 1].value;
+    // ————————————————————————————— Declarations —————————————————————————————
+    void declaration(const ASTNode* node) {
+        uint32_t varType = node->children[0]->sym;  // e.g. kwInt, kwFloat, …
+        const ASTNode* id = node->children[1];
 
-        // Redeclaration check (current scope only)
-        if (currentScope().count(varName)) {
-            error("Variable '" + varName + "' redeclared in same scope");
+        // Initializer value (literal, identifier or expression text, or “Uninitialized”)
+        string initVal = "Uninitialized";
+        if (node->childCount > 2) {
+            const ASTNode* init = node->children[2];
+            expressionType(init, "in initializer");
+            initVal = expressionText(init);
         }
 
-        // Mock memory address: allocate 4 bytes at nextAddress
-        char buf[20];
-        snprintf(buf, sizeof(buf), "0x%04X", nextAddress);
-        string addrStr = buf;
-        nextAddress += 4;
+        declare(id, varType, initVal);
+    }
 
-        // Initializer value (literal or “Uninitialized”)
-        string initVal = "Uninitialized";
-        if (match(operaTor, "=")) {
-            if (check(number)) {
-                initVal = tokens[current].value;
-                advance();
-            }
-            else if (check(identifier)) {
-                string rhsName = tokens[current].value;
-                if (!isDeclared(rhsName)) {
-                    error("Variable '" + rhsName + "' used before declaration in initializer");
-                }
-                initVal = rhsName;
-                advance();
-            }
-            else {
-                error("Only single-literal or identifier initialization supported");
-            }
+    // Adds `id` to the current scope and to the printed table.
+    void declare(const ASTNode* id, uint32_t type, const string& value) {
+        // Redeclaration check (current scope only)
+        if (scopes.declaredInCurrentScope(id->sym)) {
+            error("Variable '" + text(id->sym) + "' redeclared in same scope", id);
+            return;  // the first declaration stays in effect
         }
 
-        // Create Symbol, insert into current scope and symbolEntries
+        // Create Symbol with the next mock address (4 bytes each), insert into
+        // current scope and symbolEntries
         Symbol sym;
-        sym.type          = varType;
-        sym.scopeLevel    = currentScopeLevel;
-        sym.memoryAddress = addrStr;
-        sym.value         = initVal;
+        sym.type          = type;
+        sym.scopeLevel    = scopes.level();
+        sym.memoryAddress = nextAddress;
+        sym.value         = value;
+        nextAddress += 4;
 
-        currentScope()[varName] = sym;
-        symbolEntries.push_back({ varName, sym });
+        scopes.declare(id->sym, (int)symbolEntries.size());
+        if (deferring && scopes.level() == 0)
+            globalDecls.push_back((int)symbolEntries.size());
+        symbolEntries.push_back({ id->sym, sym });
     }
 
     // ————————————————————————————— Assignments (type-check only) —————————————————————————————
-    void assignment() {
-        advance();  // consume identifier
-        string varName = tokens[current - 1].value;
+    void assignment(const ASTNode* node, const char* context) {
+        const ASTNode* id = node->children[0];
 
-        if (!isDeclared(varName)) {
-            error("Variable '" + varName + "' used before declaration");
-        }
-        string lhsType = getType(varName);
-
-        match(operaTor, "=");
-
-        // Determine RHS type (single literal or identifier)
-        string rhsType;
-        if (check(number)) {
-            string rhsVal = tokens[current].value;
-            rhsType = (rhsVal.find('.') != string::npos) ? "float" : "int";
-            advance();
-        }
-        else if (check(identifier)) {
-            string rhsName = tokens[current].value;
-            if (!isDeclared(rhsName)) {
-                error("Variable '" + rhsName + "' used before declaration in assignment");
-            }
-            rhsType = getType(rhsName);
-            advance();
-        }
-        else {
-            error("Only single-literal or identifier assignment supported");
+        if (!isDeclared(id->sym)) {
+            error("Variable '" + text(id->sym) + "' used before declaration", id);
         }
+        uint32_t lhsType = getType(id->sym);
+        uint32_t rhsType = expressionType(node->children[1], context);
 
         if (!typesCompatible(lhsType, rhsType)) {
-            error("Cannot assign type '" + rhsType + "' to variable '" 
-                   + varName + "' (" + lhsType + ")");
+            error("Cannot assign type '" + text(rhsType) + "' to variable '" 
+                   + text(id->sym) + "' (" + text(lhsType) + ")", id);
         }
 
         // NOTE: We do NOT update `symbolEntries[].second.value` here,
         // so declaration-time “Uninitialized” remains if there was no initializer.
     }
 
-    // ————————————————————————————— Expression-Type Evaluation (unused for “value”) —————————————————————————————
-    string evaluateExpressionType() {
-        string res = primaryType();
-        while (check(operaTor, "*") || check(operaTor, "/")) {
-            advance();
-            string r = primaryType();
-            res = (res == "float" || r == "float") ? "float" : "int";
-        }
-        while (check(operaTor, "+") || check(operaTor, "-")) {
-            advance();
-            string r = primaryType();
-            res = (res == "float" || r == "float") ? "float" : "int";
+    // ————————————————————————————— Expression Types —————————————————————————————
+    // int op int → int, anything with a float → float, comparisons → bool.
+    // Operands are typed left to right (so errors come in source order), each
+    // operation once both of its operands are.
+    uint32_t expressionType(const ASTNode* root, const char* context) {
+        operandWalk.assign(1, { root, false });
+        operandTypes.clear();
+        while (!operandWalk.empty()) {
+            auto [node, queued] = operandWalk.back();
+            operandWalk.pop_back();
+            switch (node->kind) {
+            case astNumber:
+                operandTypes.push_back((node->value.find('.') != string_view::npos) ? kwFloat : kwInt);
+                break;
+            case astString:
+                operandTypes.push_back(kwString);
+                break;
+            case astIdentifier:
+                if (!isDeclared(node->sym)) {
+                    error("Variable '" + text(node->sym) + "' used before declaration " + context, node);
+                }
+                operandTypes.push_back(getType(node->sym));
+                break;
+            case astComparison:
+            case astBinary:
+                if (!queued) {
+                    operandWalk.push_back({ node, true });
+                    operandWalk.push_back({ node->children[1], false });
+                    operandWalk.push_back({ node->children[0], false });
+                } else {
+                    uint32_t r = operandTypes.back();
+                    operandTypes.pop_back();
+                    uint32_t l = operandTypes.back();
+                    operandTypes.back() = node->kind == astComparison ? kwBool
+                                        : (l == kwFloat || r == kwFloat) ? kwFloat : kwInt;
+                }
+                break;
+            default:
+                error("Invalid expression in semantic analysis", node);
+                operandTypes.push_back(Interner::none);
+                break;
+            }
         }
-        return res;
+        return operandTypes.back();
     }
 
-    string primaryType() {
-        if (match(number)) {
-            string lit = tokens[current - 1].value;
-            return (lit.find('.') != string::npos) ? "float" : "int";
-        }
-        if (match(identifier)) {
-            string name = tokens[current - 1].value;
-            if (!isDeclared(name)) {
-                error("Variable '" + name + "' used before declaration in expression");
+    // Source-like text of an initializer for the Value column; nested
+    // operations are parenthesized since the tree no longer has the originals.
+    // Written left to right from a stack of what is still to come: a subtree
+    // (bare or in parentheses), an operator, or a ')'.
+    string expressionText(const ASTNode* root) {
+        enum part : char { bare, grouped, op, close };
+        vector<pair<const ASTNode*, part>> todo{ { root, bare } };
+        string text;
+        while (!todo.empty()) {
+            auto [node, what] = todo.back();
+            todo.pop_back();
+            if (what == op) {
+                text += " ";
+                text += node->value;
+                text += " ";
+            } else if (what == close) {
+                text += ")";
+            } else if (node->kind != astBinary && node->kind != astComparison) {
+                text += node->value;
+            } else {
+                if (what == grouped) {
+                    text += "(";
+                    todo.push_back({ node, close });
+                }
+                auto side = [](const ASTNode* n) {
+                    return n->kind == astBinary || n->kind == astComparison ? grouped : bare;
+                };
+                todo.push_back({ node->children[1], side(node->children[1]) });
+                todo.push_back({ node, op });
+                todo.push_back({ node->children[0], side(node->children[0]) });
             }
-            return getType(name);
-        }
-        if (match(separator, "(")) {
-            string inner = evaluateExpressionType();
-            match(separator, ")");
-            return inner;
         }
-        error("Invalid expression in semantic analysis");
-        return "";
+        return text;
     }
 };
@@ -3,252 +3,763 @@
 #include "lexical.cpp"
 using namespace std;
 
+// Raised by Parser::error() with the bare message and the index of the token
+// it is about (the token count for end of input). The parser catches it at
+// the enclosing statement, records it and resumes.
+struct AnalysisError : runtime_error {
+    int at;
+    AnalysisError(const string& msg, int tokenIndex) : runtime_error(msg), at(tokenIndex) {}
+};
+
+// Raised once a run has recorded as many errors as its Diagnostics allow.
+struct ErrorLimitReached {};
+
+// Every error of one run, in the order found. Parser and SemanticAnalyzer
+// record into the same list and keep going, so one run reports them all;
+// the CLI prints them to stderr and exits with status 1, while the server
+// mode sends them back as one error response. A limit of 0 means no limit.
+class Diagnostics {
+    vector<string> messages;
+    size_t limit;
+
+public:
+    static constexpr size_t defaultLimit = 20;
+
+    explicit Diagnostics(size_t maxErrors = defaultLimit) : limit(maxErrors) {}
+
+    void report(string msg) {
+        messages.push_back(move(msg));
+        if (limitReached())
+            throw ErrorLimitReached{};
+    }
+
+    bool empty() const { return messages.empty(); }
+    size_t size() const { return messages.size(); }
+    const vector<string>& all() const { return messages; }
+    bool limitReached() const { return limit && messages.size() >= limit; }
+    size_t maxErrors() const { return limit; }
+
+    void print(ostream& err) const {
+        for (const string& m : messages)
+            err << m << "\n";
+        if (limitReached())
+            err << "Too many errors (limit " << limit << "), stopping.\n";
+    }
+};
+
 // Define the AST node structure
+enum nodeKind : unsigned char {
+    astProgram, astBlock, astFunction, astReturnType, astDeclaration, astType,
+    astAssignment, astIf, astWhile, astFor, astCout, astCin, astReturn,
+    astComparison, astBinary, astIdentifier, astNumber, astString
+};
+
+const char* nodeKindName(nodeKind k) {
+    static const char* const names[] = {
+        "program", "block", "function", "returnType", "declaration", "type",
+        "assignment", "if", "while", "for", "cout", "cin", "return",
+        "comparison", "binary", "identifier", "number", "string"
+    };
+    return names[k];
+}
+
+// Nodes live in the parser's Arena. Children are one contiguous array; a
+// child may be null where a statement produced nothing (e.g. a lone ';').
+// `sym` is the interned ID of identifiers, types and operators, and `value`
+// its text: interned names point into the Interner, numbers and strings are
+// copied into the arena, so a tree does not depend on the source buffer.
+// line/col locate the node for diagnostics: the first token of a statement,
+// the operator of a binary/comparison node, the token itself for leaves.
 struct ASTNode {
-    string type;
-    vector<ASTNode*> children;
-    string value;
-    ASTNode(string t, vector<ASTNode*> c = {}, string v = "") 
-      : type(t), children(c), value(v) {}
+    nodeKind kind;
+    unsigned childCount;
+    int line;
+    int col;
+    uint32_t sym;
+    ASTNode** children;
+    string_view value;
+
+    ASTNode** begin() const { return children; }
+    ASTNode** end() const { return children + childCount; }
+};
+
+// A syntax error kept by the Parser: message and token index as raised.
+struct syntaxError {
+    int at;
+    string message;
 };
 
+// One top-level statement, function or block and the tokens [begin, end) it
+// was parsed from. `node` is null for items that produce nothing (directives,
+// `using namespace std;`, stray ';') or that failed; `errors` are the syntax
+// errors raised anywhere inside the item.
+struct topLevelItem {
+    int begin;
+    int end;
+    ASTNode* node;
+    vector<syntaxError> errors;
+};
+
+// Prints the tree one node per line, indented two spaces per level. The
+// walk keeps its own stack, so any depth of nesting prints.
+void printTree(const ASTNode* root, ostream& out) {
+    vector<pair<const ASTNode*, int>> todo;  // node, indent
+    if (root)
+        todo.push_back({ root, 0 });
+    while (!todo.empty()) {
+        auto [node, indent] = todo.back();
+        todo.pop_back();
+        for (int i = 0; i < indent; i++) 
+            out << "  ";
+        out << nodeKindName(node->kind);
+        if (!node->value.empty()) 
+            out << ": " << node->value;
+        out << "\n";
+        for (unsigned k = node->childCount; k-- > 0;)
+            if (node->children[k])
+                todo.push_back({ node->children[k], indent + 1 });
+    }
+}
+
+// ————————————————————————————— Binary Operators —————————————————————————————
+// Every operator the lexer emits that can join two operands, by fixed symbol
+// ID: how tightly it binds (0: not a binary operator) and whether it makes a
+// comparison node. The tiers follow C++, except that relational and equality
+// operators share one, as they always have here.
+struct binaryOperator {
+    unsigned char precedence;
+    bool comparison;
+};
+
+constexpr array<binaryOperator, fixedSymbolCount> binaryOperators = [] {
+    array<binaryOperator, fixedSymbolCount> table{};
+    table[opPipe] = { 1, false };
+    table[opCaret] = { 2, false };
+    table[opAmp] = { 3, false };
+    for (uint32_t id : { opLess, opGreater, opLessEq, opGreaterEq, opEq, opNotEq })
+        table[id] = { 4, true };
+    table[opShl] = table[opShr] = { 5, false };
+    table[opPlus] = table[opMinus] = { 6, false };
+    table[opStar] = table[opSlash] = table[opPercent] = { 7, false };
+    return table;
+}();
+
+// ————————————————————————————— Statement Dispatch —————————————————————————————
+// The production a statement starts, by its first token: the fixed symbol ID
+// of a keyword, operator or separator, and past those one entry per token
+// type for names, literals and directives (see statementKey()).
+enum statementStart : unsigned char {
+    startUnknown, startDirective, startInt, startVoid, startDeclaration, startUsing, startBlock,
+    startIf, startWhile, startFor, startCout, startCin, startReturn, startName, startEmpty
+};
+
+constexpr uint32_t statementKeyCount = fixedSymbolCount + unknown + 1;
+
+constexpr array<statementStart, statementKeyCount> statementStarts = [] {
+    array<statementStart, statementKeyCount> table{};
+    table[fixedSymbolCount + preprocessor] = startDirective;
+    table[kwInt] = startInt;
+    table[kwVoid] = startVoid;
+    table[kwFloat] = table[kwChar] = table[kwBool] = startDeclaration;
+    table[kwUsing] = startUsing;
+    table[sepLBrace] = startBlock;
+    table[kwIf] = startIf;
+    table[kwWhile] = startWhile;
+    table[kwFor] = startFor;
+    table[kwCout] = startCout;
+    table[kwCin] = startCin;
+    table[kwReturn] = startReturn;
+    table[fixedSymbolCount + identifier] = table[idStd] = startName;
+    table[sepSemicolon] = startEmpty;
+    return table;
+}();
+
+// Index of `t` in statementStarts. Names other than "std" have IDs past the
+// fixed symbols, and literals, directives and the end of input none.
+inline uint32_t statementKey(const token& t) {
+    return t.id < fixedSymbolCount ? t.id : fixedSymbolCount + t.type;
+}
+
+// Statements the parser started, and the tests it made to pick their
+// productions: the lookup in statementStarts, plus the one lookahead that
+// tells `int name(` from a declaration without an initializer.
+struct statementCounts {
+    long statements = 0;
+    long selectionTests = 0;
+};
+
+// Statements that contain statements (blocks, functions, if, while, for)
+// are parsed on an explicit stack of frames rather than by recursion, and
+// expressions on operand and operator stacks, so nesting depth is bounded by
+// memory rather than by the native stack.
 class Parser {
-    vector<token> tokens;
+    // A compound statement whose body is still being parsed, or a guard: one
+    // statement parsed under panic-mode recovery (see guardedStatement()).
+    enum frameKind : unsigned char { frameGuard, frameBlock, frameFunction, frameIf, frameWhile, frameFor };
+    struct frame {
+        frameKind kind;
+        unsigned char state;  // which part of the statement comes next
+        int start;            // its first token
+        size_t base;          // its finished children are on `pending` from here
+    };
+
+    tokenView tokens;  // Borrowed from the caller, never copied
+    const Interner& names;  // The interner tokenize() filled
     int current = 0;
+    Arena arena;               // Owns every node of the tree
+    vector<ASTNode*> pending;  // Children of the nodes still being parsed
+    vector<frame> frames;      // Statements still being parsed, innermost last
+    vector<ASTNode*> operands;         // Expression parsing: finished subtrees,
+    vector<const token*> operators;    // and operators still to apply ('(' as null)
+    vector<topLevelItem> items;        // The program, item by item
+    vector<syntaxError>* itemErrors;   // Errors of the item being parsed
+    statementCounts counts;            // Over every parse of this Parser
     ASTNode* root; // Root of the AST
+    unsigned rootCapacity = 0;  // Children the root's array has room for
+    size_t itemBytes = 0;       // Arena bytes of the items' trees
+
+    // Tokens past its end an item's parse may depend on: it looks at one
+    // (to see that no `else` or operator continues it); one more is margin.
+    static constexpr int lookahead = 2;
 
 public:
-    Parser(const vector<token>& t) : tokens(t), root(nullptr) {}
+    Parser(const vector<token>& t, const Interner& n) : tokens(t), names(n), itemErrors(nullptr), root(nullptr) {}
+
+    // Builds the tree; it stays valid for the lifetime of this Parser.
+    // Statements with syntax errors are recorded in `diags` and left out.
+    ASTNode* parse(Diagnostics& diags) {
+        current = 0;
+        items.clear();
+        itemBytes = 0;
+        parseItems(items, INT_MAX);
+        return finish(diags);
+    }
 
-    void parse() {
-        root = new ASTNode{"program"};
+    // Brings the tree up to date after relex() changed `toks` (the same
+    // vector, edited) as described by `change`. Only the top-level items
+    // whose tokens, or lookahead, touch the change are parsed again, and
+    // only until an item ends where an old one after the change began; the
+    // remaining items are reused with their positions shifted. Replaced
+    // nodes stay in the arena until the Parser is destroyed.
+    ASTNode* reparse(const vector<token>& toks, const tokenChange& change, Diagnostics& diags) {
+        tokens = tokenView(toks);
+        int changeBegin = (int)change.begin;
+        int changeEnd = (int)(change.begin + change.removed);  // old numbering
+        int delta = (int)change.inserted - (int)change.removed;
+
+        // First item whose parse could have seen a changed token.
+        size_t first = 0;
+        while (first < items.size() && items[first].end + lookahead <= changeBegin)
+            first++;
+        // Old items from `reuse` on begin after the change.
+        size_t reuse = first;
+        while (reuse < items.size() && items[reuse].begin < changeEnd)
+            reuse++;
+
+        vector<topLevelItem> fresh;
+        current = first < items.size() ? items[first].begin : 0;  // items cover every token
         while (!isAtEnd()) {
-            ASTNode* stmt = statement();
-            if (stmt) 
-                root->children.push_back(stmt);
-        }
-        printAST(root, 0); // Print the AST after parsing
+            while (reuse < items.size() && items[reuse].begin + delta < current)
+                reuse++;
+            if (reuse < items.size() && items[reuse].begin + delta == current)
+                break;  // back in step with the old parse
+            parseItems(fresh, current + 1);
+        }
+        if (isAtEnd())
+            reuse = items.size();
+
+        // Without a line shift only nodes on the sync line move, and those
+        // are all in the items that start on or before it.
+        bool shifting = change.lineShift || change.colShift;
+        for (size_t k = reuse; k < items.size(); k++) {
+            topLevelItem& item = items[k];
+            item.begin += delta;
+            item.end += delta;
+            for (syntaxError& e : item.errors)
+                e.at += delta;
+            if (shifting && !change.lineShift && tokens[item.begin].line > change.syncLine)
+                shifting = false;
+            if (shifting)
+                shiftPositions(item.node, change);
+        }
+        for (size_t k = first; k < reuse; k++)
+            itemBytes -= treeBytes(items[k].node);
+        items.erase(items.begin() + first, items.begin() + reuse);
+        items.insert(items.begin() + first, make_move_iterator(fresh.begin()), make_move_iterator(fresh.end()));
+        return finish(diags);
     }
 
+    void print(ostream& out = cout) {
+        printTree(root, out);
+    }
+
+    // Arena bytes of the current tree, and of what earlier parses left
+    // there: the items reparse() replaced and statements that failed.
+    size_t liveBytes() const {
+        return itemBytes + (root ? sizeof(ASTNode) + rootCapacity * sizeof(ASTNode*) : 0);
+    }
+    size_t deadBytes() const { return arena.used() - liveBytes(); }
+
+    const statementCounts& dispatchCounts() const { return counts; }
+
 private:
-    // Helper function to print the AST
-    void printAST(ASTNode* node, int indent) {
-        for (int i = 0; i < indent; i++) 
-            cout << "  ";
-        cout << node->type;
-        if (!node->value.empty()) 
-            cout << ": " << node->value;
-        cout << "\n";
-        for (auto child : node->children) {
-            printAST(child, indent + 1);
+    // Parses top-level items into `out` until the end of input or until an
+    // item ends at or after token `stop`.
+    void parseItems(vector<topLevelItem>& out, int stop) {
+        while (!isAtEnd() && current < stop) {
+            out.push_back({ current, current, nullptr, {} });
+            topLevelItem& item = out.back();
+            size_t base = pending.size();
+            itemErrors = &item.errors;
+            guardedStatement();
+            item.node = pending.size() > base ? pending.back() : nullptr;
+            itemBytes += treeBytes(item.node);
+            pending.resize(base);
+            item.end = current;
+        }
+        itemErrors = nullptr;
+    }
+
+    // Points the root at the items and reports their errors in order. The
+    // root and its child array are kept from parse to parse; the array is
+    // only replaced, by one twice the size, when the items outgrow it.
+    ASTNode* finish(Diagnostics& diags) {
+        unsigned count = 0;
+        for (const topLevelItem& item : items)
+            count += item.node != nullptr;
+        if (!root)
+            root = arena.make<ASTNode>(astProgram, 0u, 0, 0, Interner::none, nullptr, string_view());
+        if (count > rootCapacity) {
+            rootCapacity = max(count, rootCapacity * 2);
+            root->children = (ASTNode**)arena.allocate(rootCapacity * sizeof(ASTNode*), alignof(ASTNode*));
+        }
+        root->childCount = 0;
+        for (const topLevelItem& item : items)
+            if (item.node)
+                root->children[root->childCount++] = item.node;
+        const token& at = tokens.size() ? tokens[0] : endOfInput;
+        root->line = at.line;
+        root->col = at.col;
+        for (const topLevelItem& item : items)
+            for (const syntaxError& e : item.errors)
+                diags.report(describe(e));
+        return root;
+    }
+
+    string describe(const syntaxError& e) {
+        const token& t = e.at < tokens.size() ? tokens[e.at] : endOfInput;
+        if (t.line == -1) {
+            return "Syntax Error: " + e.message + " (unexpected end of input)";
+        }
+        return "Syntax Error at line " + to_string(t.line) +
+               ", column " + to_string(t.col) + ": " + e.message;
+    }
+
+    // Arena bytes of the nodes, child arrays and copied text under `subtree`
+    // (text rounded up to the alignment the next node pads it to).
+    static size_t treeBytes(const ASTNode* subtree) {
+        size_t bytes = 0;
+        vector<const ASTNode*> todo;
+        if (subtree)
+            todo.push_back(subtree);
+        while (!todo.empty()) {
+            const ASTNode* n = todo.back();
+            todo.pop_back();
+            bytes += sizeof(ASTNode) + n->childCount * sizeof(ASTNode*);
+            if (n->sym == Interner::none)
+                bytes += (n->value.size() + alignof(ASTNode) - 1) & ~(alignof(ASTNode) - 1);
+            for (const ASTNode* child : *n)
+                if (child)
+                    todo.push_back(child);
+        }
+        return bytes;
+    }
+
+    // Moves a reused subtree the way relex() moved the tokens it came from.
+    void shiftPositions(ASTNode* subtree, const tokenChange& change) {
+        vector<ASTNode*> todo;
+        if (subtree)
+            todo.push_back(subtree);
+        while (!todo.empty()) {
+            ASTNode* n = todo.back();
+            todo.pop_back();
+            if (n->line == change.syncLine)
+                n->col += change.colShift;
+            n->line += change.lineShift;
+            for (ASTNode* child : *n)
+                if (child)
+                    todo.push_back(child);
         }
     }
 
+    // Node construction: fixed children are passed directly; variable-length
+    // lists are collected on `pending` and moved into the arena in one piece.
+    ASTNode* node(nodeKind kind, const token& at, initializer_list<ASTNode*> kids = {}) {
+        return arena.make<ASTNode>(kind, (unsigned)kids.size(), at.line, at.col, Interner::none,
+                                   childArray(kids.begin(), kids.size()), string_view());
+    }
+
+    ASTNode* node(nodeKind kind, const token& at, size_t pendingBase) {
+        size_t n = pending.size() - pendingBase;
+        ASTNode** arr = childArray(pending.data() + pendingBase, n);
+        pending.resize(pendingBase);
+        return arena.make<ASTNode>(kind, (unsigned)n, at.line, at.col, Interner::none, arr, string_view());
+    }
+
+    // Leaves and operator nodes take their symbol and text from token `t`.
+    ASTNode* fromToken(nodeKind kind, const token& t, initializer_list<ASTNode*> kids = {}) {
+        string_view value = t.id != Interner::none ? names.name(t.id) : arena.copy(t.value);
+        return arena.make<ASTNode>(kind, (unsigned)kids.size(), t.line, t.col, t.id,
+                                   childArray(kids.begin(), kids.size()), value);
+    }
+
+    ASTNode** childArray(ASTNode* const* src, size_t n) {
+        if (n == 0) return nullptr;
+        ASTNode** arr = (ASTNode**)arena.allocate(n * sizeof(ASTNode*), alignof(ASTNode*));
+        memcpy(arr, src, n * sizeof(ASTNode*));
+        return arr;
+    }
+
     // Basic token utilities
-    token peek() {
-        return (current < (int)tokens.size())
+    const token& peek() {
+        return (current < tokens.size())
                ? tokens[current]
-               : token{ unknown, "", -1, -1 };
+               : endOfInput;
     }
 
-    token peekNext(int offset = 1) {
+    const token& peekNext(int offset = 1) {
         int idx = current + offset;
-        if (idx < (int)tokens.size()) 
+        if (idx < tokens.size()) 
             return tokens[idx];
-        return token{ unknown, "", -1, -1 };
+        return endOfInput;
     }
 
-    token advance() {
+    const token& advance() {
         return tokens[current++];
     }
 
-    bool match(tokenType type, const string& val = "") {
-        if (current >= (int)tokens.size()) 
+    bool match(tokenType type) {
+        if (!check(type)) 
             return false;
-        if (tokens[current].type == type &&
-            (val.empty() || tokens[current].value == val)) 
-        {
-            current++;
-            return true;
-        }
-        return false;
+        current++;
+        return true;
     }
 
-    bool check(tokenType type, const string& val = "") {
+    // Keywords, operators and separators are matched by symbol ID alone.
+    bool match(fixedSymbol sym) {
+        if (!check(sym)) 
+            return false;
+        current++;
+        return true;
+    }
+
+    bool check(tokenType type) {
         if (isAtEnd()) 
             return false;
-        return (tokens[current].type == type) &&
-               (val.empty() || tokens[current].value == val);
+        return tokens[current].type == type;
+    }
+
+    bool check(fixedSymbol sym) {
+        if (isAtEnd()) 
+            return false;
+        return tokens[current].id == sym;
     }
 
     bool isAtEnd() {
-        return current >= (int)tokens.size();
+        return current >= tokens.size();
     }
 
     void error(const string& msg) {
-        token t = peek();
-        if (t.line == -1) {
-            cerr << "Syntax Error: " << msg << " (unexpected end of input)\n";
-        } else {
-            cerr << "Syntax Error at line " << t.line 
-                 << ", column " << t.col << ": " << msg << "\n";
+        throw AnalysisError(msg, current);
+    }
+
+    // Panic-mode recovery: parses one statement onto `pending`; on a syntax
+    // error the partial statement is dropped and tokens are skipped through
+    // the next ';' or up to the next '}', whichever comes first. Every
+    // statement of a block is guarded in turn, so an error only unwinds the
+    // frames up to the innermost guard.
+    void guardedStatement() {
+        size_t outer = frames.size();
+        open(frameGuard, current);
+        while (frames.size() > outer) {
+            try {
+                step();
+            } catch (const AnalysisError& e) {
+                while (frames.back().kind != frameGuard)
+                    frames.pop_back();
+                frame guard = frames.back();
+                frames.pop_back();
+                pending.resize(guard.base);
+                itemErrors->push_back({ e.at, e.what() });
+                synchronize(guard.start);
+            }
         }
-        exit(1);
     }
 
-    void expect(const string& symbol, const string& errMsg) {
-        if (!match(operaTor, symbol) && !match(separator, symbol)) {
-            error(errMsg);
+    void open(frameKind kind, int start) {
+        frames.push_back({ kind, 0, start, pending.size() });
+    }
+
+    // Pops the finished frame and pushes its node, made from its children.
+    void complete(nodeKind kind) {
+        frame f = frames.back();
+        frames.pop_back();
+        pending.push_back(node(kind, tokens[f.start], f.base));
+    }
+
+    // Takes the innermost frame one part further: starts its next statement
+    // or, when none is left, completes it.
+    void step() {
+        frame& f = frames.back();
+        switch (f.kind) {
+        case frameGuard:
+            if (f.state++ == 0) {
+                statement();
+            } else {
+                // The statement's node is on top; null ones are left out.
+                if (!pending.back())
+                    pending.pop_back();
+                frames.pop_back();
+            }
+            break;
+        case frameBlock:
+            // Collect statements until matching "}"
+            if (!check(sepRBrace) && !isAtEnd()) {
+                open(frameGuard, current);
+            } else {
+                expect(sepRBrace, "Expected '}' to close block.");
+                complete(astBlock);
+            }
+            break;
+        case frameFunction:
+            if (f.state++ == 0)
+                block();
+            else
+                complete(astFunction);
+            break;
+        case frameIf:
+            if (f.state == 0) {
+                f.state = 1;
+                statement();
+            } else if (f.state == 1 && match(kwElse)) {
+                f.state = 2;
+                statement();
+            } else {
+                complete(astIf);
+            }
+            break;
+        case frameWhile:
+        case frameFor:
+            if (f.state++ == 0)
+                statement();
+            else
+                complete(f.kind == frameWhile ? astWhile : astFor);
+            break;
+        }
+    }
+
+    void synchronize(int start) {
+        while (!isAtEnd()) {
+            if (match(sepSemicolon))
+                return;
+            if (check(sepRBrace)) {
+                if (current == start)
+                    advance();  // a stray '}' the statement failed on
+                return;         // otherwise it closes the enclosing block
+            }
+            advance();
         }
     }
 
-    bool isValidTypeKeyword() {
-        return check(keyword, "int") || check(keyword, "float") ||
-               check(keyword, "char") || check(keyword, "bool");
+    void expect(fixedSymbol symbol, const char* errMsg) {
+        if (!match(symbol)) {
+            error(errMsg);
+        }
     }
 
-    // Modified parsing functions to return ASTNode*
-    ASTNode* statement() {
+    // Starts the statement at `current`. A simple statement is parsed whole
+    // and its node, or null if it produces none, pushed onto `pending`; a
+    // compound one opens a frame, which pushes its node once complete. The
+    // production is picked by one lookup in statementStarts. Functions and
+    // declarations both start `int name`, so that prefix is parsed before
+    // they are told apart, by the token after the name; the other tokens a
+    // production needs (the name and '(' after `void`, the '=' after a name)
+    // are checked as it consumes them, and one missing makes the statement
+    // unknown just as if it had not been picked.
+    void statement() {
+        const token& first = peek();
+        int start = current;
+        counts.statements++;
+        counts.selectionTests++;  // the lookup
+        switch (statementStarts[statementKey(first)]) {
         // 1) Skip any preprocessor directive entirely:
-        if (check(preprocessor)) {
+        case startDirective:
             advance();
-            return nullptr;
-        }
+            pending.push_back(nullptr);
+            return;
 
-        // 2) Function declaration (e.g., "int foo()" or "void bar()")
-        if ((check(keyword, "int") || check(keyword, "void")) &&
-            peekNext().type == identifier &&
-            peekNext(2).type == separator && peekNext(2).value == "(") 
-        {
-            return function_decl();
+        // 2) Function declaration (e.g., "int foo()" or "void bar()"),
+        //    else for int a declaration as in 5)
+        case startInt: {
+            advance();
+            if (!match(identifier))
+                error("Expected identifier in declaration.");
+            bool initialized = match(opAssign);
+            if (!initialized) {
+                counts.selectionTests++;  // '(' or the rest of a declaration
+                if (match(sepLParen)) {
+                    function_decl(start);
+                    return;
+                }
+            }
+            ASTNode* decl = declarationValue(first, tokens[start + 1], initialized);
+            expect(sepSemicolon, "Expected ';' after declaration.");
+            pending.push_back(decl);
+            return;
+        }
+
+        case startVoid:
+            advance();
+            if (!match(identifier) || !match(sepLParen)) {
+                current = start;  // reported at 'void'
+                break;
+            }
+            function_decl(start);
+            return;
+
+        // 5) Declaration: e.g., "int x;" or "float y = 3;"
+        case startDeclaration: {
+            ASTNode* decl = declaration();
+            expect(sepSemicolon, "Expected ';' after declaration.");
+            pending.push_back(decl);
+            return;
         }
 
         // 3) using namespace std;
-        if (match(keyword, "using")) {
-            if (!match(keyword, "namespace")) 
+        case startUsing:
+            advance();
+            if (!match(kwNamespace)) 
                 error("Expected 'namespace' after 'using'");
-            if (!match(identifier, "std")) 
+            if (!match(idStd)) 
                 error("Expected 'std' after 'namespace'");
-            expect(";", "Expected ';' after using namespace std");
-            return nullptr; // ignore this in the AST
-        }
+            expect(sepSemicolon, "Expected ';' after using namespace std");
+            pending.push_back(nullptr); // ignore this in the AST
+            return;
 
         // 4) Block: "{ ... }"
-        if (check(separator, "{")) {
-            return block();
-        }
-
-        // 5) Declaration: e.g., "int x;" or "float y = 3;"
-        if (isValidTypeKeyword()) {
-            ASTNode* decl = declaration();
-            expect(";", "Expected ';' after declaration.");
-            return decl;
-        }
+        case startBlock:
+            block();
+            return;
 
         // 6) if-statement
-        if (check(keyword, "if")) {
-            return if_stmt();
-        }
+        case startIf:
+            if_stmt();
+            return;
 
         // 7) while-statement
-        if (check(keyword, "while")) {
-            return while_stmt();
-        }
+        case startWhile:
+            while_stmt();
+            return;
 
         // 8) for-statement
-        if (check(keyword, "for")) {
-            return for_stmt();
-        }
+        case startFor:
+            for_stmt();
+            return;
 
         // 9) cout-statement
-        if (check(keyword, "cout")) {
+        case startCout: {
             advance(); // consume 'cout'
             ASTNode* coutNode = cout_stmt();
-            expect(";", "Expected ';' after cout statement.");
-            return coutNode;
+            expect(sepSemicolon, "Expected ';' after cout statement.");
+            pending.push_back(coutNode);
+            return;
         }
 
         // 10) cin-statement
-        if (check(keyword, "cin")) {
+        case startCin: {
             advance(); // consume 'cin'
             ASTNode* cinNode = cin_stmt();
-            expect(";", "Expected ';' after cin statement.");
-            return cinNode;
+            expect(sepSemicolon, "Expected ';' after cin statement.");
+            pending.push_back(cinNode);
+            return;
         }
 
         // 11) return-statement
-        if (check(keyword, "return")) {
-            return return_stmt();
-        }
+        case startReturn:
+            pending.push_back(return_stmt());
+            return;
 
         // 12) assignment (identifier = expression;)
-        if (check(identifier) && peekNext().type == operaTor && peekNext().value == "=") {
-            ASTNode* assign = assignment();
-            expect(";", "Expected ';' after assignment.");
-            return assign;
+        case startName: {
+            advance();
+            if (!match(opAssign)) {
+                current = start;  // reported at the name
+                break;
+            }
+            ASTNode* assign = assignmentValue(first);
+            expect(sepSemicolon, "Expected ';' after assignment.");
+            pending.push_back(assign);
+            return;
         }
 
         // 13) Standalone semicolon or unknown separators can be skipped
-        if (check(separator, ";")) {
+        case startEmpty:
             advance();
-            return nullptr;
+            pending.push_back(nullptr);
+            return;
+
+        case startUnknown:
+            break;
         }
 
         // 14) If we reach here and it's not the end, it's an unknown statement
         error("Unknown statement");
-        return nullptr;
     }
 
-    ASTNode* block() {
-        expect("{", "Expected '{' to begin block.");
-        ASTNode* blockNode = new ASTNode{"block"};
-        // Collect statements until matching "}"
-        while (!check(separator, "}") && !isAtEnd()) {
-            ASTNode* stmt = statement();
-            if (stmt) 
-                blockNode->children.push_back(stmt);
-        }
-        expect("}", "Expected '}' to close block.");
-        return blockNode;
+    // Opens a block; step() collects its statements.
+    void block() {
+        int start = current;
+        expect(sepLBrace, "Expected '{' to begin block.");
+        open(frameBlock, start);
     }
 
     ASTNode* cout_stmt() {
-        ASTNode* coutNode = new ASTNode{"cout"};
-        if (!match(operaTor, "<<")) 
+        const token& start = tokens[current-1];  // 'cout'
+        size_t base = pending.size();
+        if (!match(opShl)) 
             error("Expected '<<' after 'cout'");
-        ASTNode* val = cout_value();
-        coutNode->children.push_back(val);
-        while (match(operaTor, "<<")) {
-            val = cout_value();
-            coutNode->children.push_back(val);
+        pending.push_back(cout_value());
+        while (match(opShl)) {
+            pending.push_back(cout_value());
         }
-        return coutNode;
+        return node(astCout, start, base);
     }
 
     ASTNode* cin_stmt() {
-        ASTNode* cinNode = new ASTNode{"cin"};
-        if (!match(operaTor, ">>")) 
+        const token& start = tokens[current-1];  // 'cin'
+        size_t base = pending.size();
+        if (!match(opShr)) 
             error("Expected '>>' after 'cin'");
         if (!match(identifier)) 
             error("Expected identifier after '>>'");
-        cinNode->children.push_back(new ASTNode{"identifier", {}, tokens[current-1].value});
-        while (match(operaTor, ">>")) {
+        pending.push_back(fromToken(astIdentifier, tokens[current-1]));
+        while (match(opShr)) {
             if (!match(identifier)) 
                 error("Expected identifier after '>>'");
-            cinNode->children.push_back(new ASTNode{"identifier", {}, tokens[current-1].value});
+            pending.push_back(fromToken(astIdentifier, tokens[current-1]));
         }
-        return cinNode;
+        return node(astCin, start, base);
     }
 
     ASTNode* cout_value() {
         if (match(stringtype)) {
-            return new ASTNode{"string", {}, tokens[current-1].value};
+            return fromToken(astString, tokens[current-1]);
         }
         else if (match(identifier)) {
-            return new ASTNode{"identifier", {}, tokens[current-1].value};
+            return fromToken(astIdentifier, tokens[current-1]);
         }
         else if (match(number)) {
-            return new ASTNode{"number", {}, tokens[current-1].value};
+            return fromToken(astNumber, tokens[current-1]);
         }
         else {
             error("Expected string, identifier, or number in cout");
@@ -257,164 +768,173 @@ private:
     }
 
     ASTNode* return_stmt() {
-        match(keyword, "return");
-        ASTNode* returnNode = new ASTNode{"return"};
-        if (!check(separator, ";")) {
+        const token& start = peek();
+        match(kwReturn);
+        ASTNode* returnNode;
+        if (!check(sepSemicolon)) {
             ASTNode* expr = expression();
-            returnNode->children.push_back(expr);
+            returnNode = node(astReturn, start, {expr});
+        } else {
+            returnNode = node(astReturn, start);
         }
-        expect(";", "Expected ';' after return statement.");
+        expect(sepSemicolon, "Expected ';' after return statement.");
         return returnNode;
     }
 
     ASTNode* declaration() {
-        string typeStr = peek().value;
+        const token& typeTok = peek();
         type();
         if (!match(identifier)) 
             error("Expected identifier in declaration.");
-        string id = tokens[current-1].value;
-        ASTNode* declNode = new ASTNode{"declaration"};
-        declNode->children.push_back(new ASTNode{"type", {}, typeStr});
-        declNode->children.push_back(new ASTNode{"identifier", {}, id});
-        if (match(operaTor, "=")) {
+        const token& name = tokens[current-1];
+        return declarationValue(typeTok, name, match(opAssign));
+    }
+
+    // The rest of a declaration whose type and name, and '=' if
+    // `initialized`, have been consumed.
+    ASTNode* declarationValue(const token& typeTok, const token& name, bool initialized) {
+        ASTNode* typeNode = fromToken(astType, typeTok);
+        ASTNode* idNode = fromToken(astIdentifier, name);
+        if (initialized) {
             ASTNode* expr = expression();
-            declNode->children.push_back(expr);
+            return node(astDeclaration, typeTok, {typeNode, idNode, expr});
         }
-        return declNode;
+        return node(astDeclaration, typeTok, {typeNode, idNode});
     }
 
     ASTNode* assignment() {
         if (!match(identifier)) 
             error("Expected identifier in assignment.");
-        string id = tokens[current-1].value;
-        expect("=", "Expected '=' in assignment.");
+        const token& id = tokens[current-1];
+        expect(opAssign, "Expected '=' in assignment.");
+        return assignmentValue(id);
+    }
+
+    // The value of an assignment to `id`, whose name and '=' have been consumed.
+    ASTNode* assignmentValue(const token& id) {
         ASTNode* expr = expression();
-        ASTNode* assignNode = new ASTNode{"assignment"};
-        assignNode->children.push_back(new ASTNode{"identifier", {}, id});
-        assignNode->children.push_back(expr);
-        return assignNode;
+        return node(astAssignment, id, {fromToken(astIdentifier, id), expr});
     }
 
-    ASTNode* if_stmt() {
-        match(keyword, "if");
-        expect("(", "Expected '(' after 'if'.");
+    // The statements of if, while and for follow in step(); their frames
+    // start with the condition (and for's assignments) on `pending`.
+    void if_stmt() {
+        int start = current;
+        match(kwIf);
+        expect(sepLParen, "Expected '(' after 'if'.");
         ASTNode* condition = comparison();
-        expect(")", "Expected ')' after condition.");
-        ASTNode* thenStmt = statement();
-        ASTNode* ifNode = new ASTNode{"if"};
-        ifNode->children.push_back(condition);
-        ifNode->children.push_back(thenStmt);
-        if (match(keyword, "else")) {
-            ASTNode* elseStmt = statement();
-            ifNode->children.push_back(elseStmt);
-        }
-        return ifNode;
+        expect(sepRParen, "Expected ')' after condition.");
+        open(frameIf, start);
+        pending.push_back(condition);
     }
 
-    ASTNode* while_stmt() {
-        match(keyword, "while");
-        expect("(", "Expected '(' after 'while'.");
+    void while_stmt() {
+        int start = current;
+        match(kwWhile);
+        expect(sepLParen, "Expected '(' after 'while'.");
         ASTNode* condition = comparison();
-        expect(")", "Expected ')' after condition.");
-        ASTNode* body = statement();
-        ASTNode* whileNode = new ASTNode{"while"};
-        whileNode->children.push_back(condition);
-        whileNode->children.push_back(body);
-        return whileNode;
+        expect(sepRParen, "Expected ')' after condition.");
+        open(frameWhile, start);
+        pending.push_back(condition);
     }
 
-    ASTNode* for_stmt() {
-        match(keyword, "for");
-        expect("(", "Expected '(' after 'for'.");
+    void for_stmt() {
+        int start = current;
+        match(kwFor);
+        expect(sepLParen, "Expected '(' after 'for'.");
         ASTNode* init = assignment();
-        expect(";", "Expected ';' after init assignment.");
+        expect(sepSemicolon, "Expected ';' after init assignment.");
         ASTNode* condition = comparison();
-        expect(";", "Expected ';' after loop condition.");
+        expect(sepSemicolon, "Expected ';' after loop condition.");
         ASTNode* increment = assignment();
-        expect(")", "Expected ')' after increment.");
-        ASTNode* body = statement();
-        ASTNode* forNode = new ASTNode{"for"};
-        forNode->children.push_back(init);
-        forNode->children.push_back(condition);
-        forNode->children.push_back(increment);
-        forNode->children.push_back(body);
-        return forNode;
+        expect(sepRParen, "Expected ')' after increment.");
+        open(frameFor, start);
+        pending.insert(pending.end(), {init, condition, increment});
     }
 
+    // A condition: an expression, or comparisons of expressions.
     ASTNode* comparison() {
-        ASTNode* left = expression();
-        while (match(operaTor, "<") || match(operaTor, ">") ||
-               match(operaTor, "==") || match(operaTor, "!=") ||
-               match(operaTor, "<=") || match(operaTor, ">=")) 
-        {
-            string op = tokens[current-1].value;
-            ASTNode* right = expression();
-            ASTNode* compNode = new ASTNode{"comparison", {left, right}, op};
-            left = compNode;
-        }
-        return left;
+        return expression(true);
     }
 
-    ASTNode* expression() {
-        ASTNode* left = term();
-        while (match(operaTor, "+") || match(operaTor, "-")) {
-            string op = tokens[current-1].value;
-            ASTNode* right = term();
-            left = new ASTNode{"binary", {left, right}, op};
-        }
-        return left;
+    // Binding strength of a binary operator; 0 for any other token.
+    // Comparisons only count where `comparisons` allows.
+    static int precedence(uint32_t id, bool comparisons) {
+        if (id >= fixedSymbolCount)  // names, and literals (Interner::none)
+            return 0;
+        const binaryOperator& op = binaryOperators[id];
+        return op.comparison && !comparisons ? 0 : op.precedence;
     }
 
-    ASTNode* term() {
-        ASTNode* left = factor();
-        while (match(operaTor, "*") || match(operaTor, "/")) {
-            string op = tokens[current-1].value;
-            ASTNode* right = factor();
-            left = new ASTNode{"binary", {left, right}, op};
+    // Operands (numbers, identifiers, parenthesized expressions) joined by
+    // the operators of binaryOperators, left-associative, and with
+    // `comparisons` by < > == != <= >= outside parentheses. Instead of one
+    // call per precedence tier and parenthesis, operands wait on `operands`
+    // and operators on `operators` until an operator that binds no tighter,
+    // or a ')', applies them.
+    ASTNode* expression(bool comparisons = false) {
+        operands.clear();
+        operators.clear();
+        int groups = 0;  // parentheses still open
+        while (true) {
+            while (match(sepLParen)) {
+                operators.push_back(nullptr);
+                groups++;
+            }
+            if (match(number))
+                operands.push_back(fromToken(astNumber, tokens[current-1]));
+            else if (match(identifier))
+                operands.push_back(fromToken(astIdentifier, tokens[current-1]));
+            else
+                error("Expected number, identifier or '('");
+
+            while (true) {
+                int prec = isAtEnd() ? 0 : precedence(peek().id, comparisons && groups == 0);
+                if (prec) {
+                    reduce(prec);
+                    operators.push_back(&advance());
+                    break;  // on to its right operand
+                }
+                reduce(1);
+                if (groups == 0)
+                    return operands.back();
+                expect(sepRParen, "Expected ')' after expression.");
+                operators.pop_back();  // the group's '('
+                groups--;
+            }
         }
-        return left;
     }
 
-    ASTNode* factor() {
-        if (match(number)) {
-            return new ASTNode{"number", {}, tokens[current-1].value};
-        }
-        else if (match(identifier)) {
-            return new ASTNode{"identifier", {}, tokens[current-1].value};
-        }
-        else if (match(separator, "(")) {
-            ASTNode* expr = expression();
-            expect(")", "Expected ')' after expression.");
-            return expr;
-        }
-        else {
-            error("Expected number, identifier or '('");
-            return nullptr;
+    // Applies the stacked operators, back to the innermost '(', that bind
+    // at least as tightly as `minPrec`.
+    void reduce(int minPrec) {
+        while (!operators.empty() && operators.back() &&
+               precedence(operators.back()->id, true) >= minPrec) {
+            const token& op = *operators.back();
+            operators.pop_back();
+            ASTNode* right = operands.back();
+            operands.pop_back();
+            nodeKind kind = binaryOperators[op.id].comparison ? astComparison : astBinary;
+            operands.back() = fromToken(kind, op, {operands.back(), right});
         }
     }
 
-    ASTNode* function_decl() {
-        string returnType = peek().value;
-        type();
-        if (!match(identifier)) 
-            error("Expected function name after return type");
-        string funcName = tokens[current-1].value;
-        expect("(", "Expected '(' after function name");
-        expect(")", "Expected ')' after function parameters");
-        ASTNode* body = block();
-        ASTNode* funcNode = new ASTNode{"function"};
-        funcNode->children.push_back(new ASTNode{"returnType", {}, returnType});
-        funcNode->children.push_back(new ASTNode{"identifier", {}, funcName});
-        funcNode->children.push_back(body);
-        return funcNode;
+    // The function starting at `start`, whose return type, name and '(' have
+    // been consumed.
+    void function_decl(int start) {
+        const token& funcName = tokens[start + 1];
+        expect(sepRParen, "Expected ')' after function parameters");
+        open(frameFunction, start);  // the body follows in step()
+        pending.push_back(fromToken(astReturnType, tokens[start]));
+        pending.push_back(fromToken(astIdentifier, funcName));
     }
 
     void type() {
-        if (!(match(keyword, "int")   ||
-              match(keyword, "float") ||
-              match(keyword, "char")  ||
-              match(keyword, "bool")  ||
-              match(keyword, "void"))) 
+        if (!(match(kwInt)   ||
+              match(kwFloat) ||
+              match(kwChar)  ||
+              match(kwBool)  ||
+              match(kwVoid))) 
         {
             error("Expected type (int, float, char, bool, void)");
         }